@@ -0,0 +1,140 @@
+// part of SDL2lazy
+// frame throughput benchmark
+// author: Ulrike Hager
+
+/*! \file lazy-bench.cc
+
+  Renders generated scenes without a visible window and prints one CSV line per scene and render mode:\n
+  items,mode,frames,seconds,fps,ns_per_item,draw_calls,drawn,culled,occluded\n
+  Usage: lazy-bench [frames [items ...]], defaults are 100 frames and scenes of 1000, 10000, and 100000 items.\n
+  Uses SDL's dummy video driver and software renderer unless SDL_VIDEODRIVER or SDL_RENDER_DRIVER are set.
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <SDL2/SDL.h>
+
+#include "SlSprite.h"
+#include "SlManager.h"
+
+const int SCREEN_WIDTH = 1280;
+const int SCREEN_HEIGHT = 720;
+const int TEXTURES = 8;
+const int SPRITE_SIZE = 32;
+const std::string SCENE_FILE = "lazy-bench-scene.ini";
+
+
+
+/*! Writes the texture definitions of the scene. Each rectangle texture automatically gets a sprite of the same name.
+ */
+void
+writeScene(const std::string& filename)
+{
+  std::ofstream output(filename, std::ofstream::out);
+  for ( int i = 0 ; i < TEXTURES ; ++i ) {
+    output << "texture\n"
+	   << "\ttype\trectangle\n"
+	   << "\tname\ttex" << i << "\n"
+	   << "\tdimensions\t" << SPRITE_SIZE << "\t" << SPRITE_SIZE << "\n"
+	   << "\tcolor\t" << (37 * i) % 256 << "\t" << (91 * i) % 256 << "\t" << (53 * i + 100) % 256 << "\t255\n"
+	   << "end\n";
+  }
+}
+
+
+
+/*! Adds items render queue entries. Items come in runs of 16 with the same texture, every 4th uses colour mod, every 8th is rotated. Positions are pseudo-random, a few items are outside the window.
+ */
+void
+fillQueue(SlManager* mngr, unsigned int items)
+{
+  std::vector<unsigned int> destinations(TEXTURES, 0);
+  uint32_t random = 12345;
+  for ( unsigned int i = 0 ; i < items ; ++i ) {
+    std::string name = "tex" + std::to_string( (i / 16) % TEXTURES );
+    std::shared_ptr<SlSprite> sprite = mngr->findSprite(name);
+    unsigned int& destination = destinations[ (i / 16) % TEXTURES ];
+    if ( destination > 0 ) sprite->addDestination(0, 0);
+
+    random = random * 1664525u + 1013904223u;
+    int x = static_cast<int>( random % (SCREEN_WIDTH + 2 * SPRITE_SIZE) ) - SPRITE_SIZE;
+    random = random * 1664525u + 1013904223u;
+    int y = static_cast<int>( random % (SCREEN_HEIGHT + 2 * SPRITE_SIZE) ) - SPRITE_SIZE;
+    sprite->setDestinationOrigin(x, y, destination);
+    if ( i % 4 == 0 ) {
+      sprite->setColor( random & 0xFF, (random >> 8) & 0xFF, (random >> 16) & 0xFF, 0xFF, destination );
+      sprite->setRenderOptions( SL_RENDER_COLORMOD, destination );
+    }
+    if ( i % 8 == 0 ) sprite->setAngle( i % 360, destination );
+
+    mngr->appendToRenderQueue(name, destination);
+    ++destination;
+  }
+}
+
+
+
+/*! Renders frames frames of a scene with items queue items in the given mode and prints the result line.
+ */
+void
+runScene(unsigned int items, unsigned int frames, const std::string& mode)
+{
+  SlManager* mngr = new SlManager("lazy-bench", SCREEN_WIDTH, SCREEN_HEIGHT);
+  if ( mode == "batch" && !mngr->setBatchRendering(true) ) {
+    std::cerr << "batch rendering needs SDL 2.0.18, skipping" << std::endl;
+    delete mngr;
+    return;
+  }
+  mngr->parseConfigurationFile(SCENE_FILE);
+  fillQueue(mngr, items);
+
+  //! Warm up texture state and caches.
+  for ( int i = 0 ; i < 3 ; ++i ) mngr->render();
+
+  unsigned long drawCalls = 0;
+  uint64_t start = SDL_GetPerformanceCounter();
+  for ( unsigned int i = 0 ; i < frames ; ++i ) {
+    mngr->render();
+    drawCalls += mngr->renderStats().drawCalls;
+  }
+  double seconds = static_cast<double>( SDL_GetPerformanceCounter() - start ) / SDL_GetPerformanceFrequency();
+  const SlRenderStats& stats = mngr->renderStats();
+
+  std::printf("%u,%s,%u,%.6f,%.2f,%.2f,%.1f,%u,%u,%u\n", items, mode.c_str(), frames, seconds,
+	      frames / seconds, 1.0e9 * seconds / ( static_cast<double>(frames) * items ),
+	      static_cast<double>(drawCalls) / frames, stats.drawn, stats.culled, stats.occluded );
+  std::fflush(stdout);
+  delete mngr;
+}
+
+
+
+int main(int argc, char* argv[])
+{
+  SDL_setenv("SDL_VIDEODRIVER", "dummy", 0);
+  SDL_setenv("SDL_RENDER_DRIVER", "software", 0);
+
+  unsigned int frames = 100;
+  std::vector<unsigned int> scenes = {1000, 10000, 100000};
+  if ( argc > 1 ) frames = std::strtoul(argv[1], nullptr, 10);
+  if ( argc > 2 ) {
+    scenes.clear();
+    for ( int i = 2 ; i < argc ; ++i ) scenes.push_back( std::strtoul(argv[i], nullptr, 10) );
+  }
+
+  writeScene(SCENE_FILE);
+  std::printf("items,mode,frames,seconds,fps,ns_per_item,draw_calls,drawn,culled,occluded\n");
+  for ( auto items: scenes ) {
+    runScene(items, frames, "direct");
+    runScene(items, frames, "batch");
+  }
+  std::remove( SCENE_FILE.c_str() );
+
+  return 0;
+}
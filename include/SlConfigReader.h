@@ -0,0 +1,113 @@
+// part of SDL2lazy
+// author: Ulrike Hager
+
+/*! \file SlConfigReader.h
+ \brief SlConfigReader class, line and token reader for configuration files.
+*/
+
+#ifndef SLCONFIGREADER_H
+#define SLCONFIGREADER_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+/*! \class SlConfigReader
+  Reads a configuration file line by line and splits the lines into whitespace separated tokens.\n
+  The file is memory-mapped (read into one buffer where mmap isn't available), tokens are std::string_view into the mapping, so reading doesn't copy.
+  The views stay valid as long as the reader exists.\n
+  Shared by SlManager::parseConfigurationFile() and all section parsers: the section parsers continue with nextLine() on the same reader until their "end" line.
+ */
+class SlConfigReader
+{
+ public:
+  /*! Maps filename.
+    \throws std::runtime_error if the file can't be opened.
+   */
+  SlConfigReader(const std::string& filename);
+  /*! Unmaps the file.
+   */
+  ~SlConfigReader();
+  /*! Deleted, the reader owns the mapping.
+   */
+  SlConfigReader(const SlConfigReader&) = delete;
+  /*! Deleted, the reader owns the mapping.
+   */
+  SlConfigReader& operator=(const SlConfigReader&) = delete;
+
+  /*! Name of the file.
+   */
+  const std::string& filename() const {return filename_;}
+  /*! The current line without the line break.
+   */
+  std::string_view line() const {return std::string_view(data_ + lineStart_, lineEnd_ - lineStart_);}
+  /*! Number of the current line, starting at 1. 0 before the first nextLine().
+   */
+  unsigned int lineNumber() const {return lineNumber_;}
+  /*! Next token in the current line.
+    \retval empty view at the end of the line.
+   */
+  std::string_view next();
+  /*! Converts the next token in the current line to an integer or floating point value. Leaves value unchanged if there is no token or it isn't a number.
+    \retval false if value wasn't set.
+   */
+  template<typename T>
+    bool next(T& value);
+  /*! Moves to the next line.
+    \retval false at the end of the file.
+   */
+  bool nextLine();
+  /*! The rest of the current line, leading whitespace skipped. Moves to the end of the line.
+   */
+  std::string_view rest();
+  /*! Copies the remaining tokens of the current line into tokens. Moves to the end of the line.
+   */
+  void rest(std::vector<std::string>& tokens);
+
+ private:
+  /*! Number conversion for next(T&).
+   */
+  static bool toNumber(std::string_view token, long long& value);
+  /*! Number conversion for next(T&).
+   */
+  static bool toNumber(std::string_view token, double& value);
+
+  /*! Name of the mapped file.
+   */
+  std::string filename_;
+  /*! Start of the file contents.
+   */
+  const char* data_ = nullptr;
+  /*! Size of the file.
+   */
+  std::size_t size_ = 0;
+  /*! The contents if the file couldn't be mapped.
+   */
+  std::string buffer_;
+  /*! True if #data_ is a mapping that has to be unmapped.
+   */
+  bool isMapped_ = false;
+  /*! Offset of the current line.
+   */
+  std::size_t lineStart_ = 0;
+  /*! Offset of the end of the current line.
+   */
+  std::size_t lineEnd_ = 0;
+  /*! Offset of the next character to tokenize in the current line.
+   */
+  std::size_t cursor_ = 0;
+  /*! Offset where the next line starts.
+   */
+  std::size_t nextStart_ = 0;
+  /*! Current line number.
+   */
+  unsigned int lineNumber_ = 0;
+};
+
+/*! Include template implementation so the compiler can generate the required functions.
+ */
+#include "SlConfigReader.hpp"
+
+#endif  /* SLCONFIGREADER_H */
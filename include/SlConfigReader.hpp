@@ -0,0 +1,23 @@
+// part of SDL2lazy
+// author: Ulrike Hager
+
+/*! \file SlConfigReader.hpp
+
+  SlConfigReader template implementation, included in SlConfigReader.h
+*/
+
+#include <type_traits>
+
+
+
+template<typename T> bool
+SlConfigReader::next(T& value)
+{
+  static_assert( std::is_arithmetic<T>::value, "SlConfigReader::next() converts to numbers only" );
+  std::string_view token = next();
+  if ( token.empty() ) return false;
+  typename std::conditional< std::is_integral<T>::value, long long, double >::type converted;
+  if ( !toNumber(token, converted) ) return false;
+  value = static_cast<T>(converted);
+  return true;
+}
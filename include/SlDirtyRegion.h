@@ -0,0 +1,69 @@
+// part of SDL2lazy
+// author: Ulrike Hager
+
+/*! \file SlDirtyRegion.h
+  \brief SlDirtyRegion class, collects the screen areas that changed since the last frame.
+*/
+
+#ifndef SLDIRTYREGION_H
+#define SLDIRTYREGION_H
+
+#include <vector>
+
+#include <SDL2/SDL.h>
+
+
+/*! \class SlDirtyRegion
+  Collects the rectangles that have to be redrawn. SlSprite adds the old and new bounding box of a destination whenever it changes, render queue manipulations add the destinations they insert, remove, reorder, or toggle.\n
+  merge() combines overlapping rectangles. If there are too many rectangles or they cover most of the window, the whole window is marked dirty instead.
+ */
+class SlDirtyRegion
+{
+ public:
+  /*! Default constructor.
+   */
+  SlDirtyRegion();
+  /*! Default destructor.
+   */
+  ~SlDirtyRegion();
+
+  /*! Adds a changed rectangle.
+   */
+  void add(const SDL_Rect& rect);
+  /*! Empties the region. Called after each frame.
+   */
+  void clear();
+  /*! Marks the whole window as dirty.
+   */
+  void invalidateAll();
+  /*! Returns true if nothing changed since the last clear().
+   */
+  bool isEmpty() const {return ( !isFull_ && rects_.empty() );}
+  /*! Returns true if the whole window has to be redrawn.
+   */
+  bool isFull() const {return isFull_;}
+  /*! Clips the rectangles to the window and merges overlapping ones. Switches to isFull() if more than #maxRects remain or they cover more than half the window.
+    \retval The merged rectangles, empty if isFull().
+   */
+  const std::vector<SDL_Rect>& merge();
+  /*! Sets the window dimensions.
+   */
+  void setBounds(int width, int height);
+  /*! Maximum number of separate rectangles before the whole window is redrawn.
+   */
+  unsigned int maxRects = 32;
+
+ private:
+  /*! The window, rectangles are clipped to it.
+   */
+  SDL_Rect bounds_ = {0,0,0,0};
+  /*! True if the whole window has to be redrawn.
+   */
+  bool isFull_ = true;
+  /*! Changed rectangles.
+   */
+  std::vector<SDL_Rect> rects_;
+};
+
+
+#endif  /* SLDIRTYREGION_H */
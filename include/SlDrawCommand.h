@@ -0,0 +1,44 @@
+// part of SDL2lazy
+// author: Ulrike Hager
+
+/*! \file SlDrawCommand.h
+  \brief SlDrawCommand struct, everything needed to draw one render queue item.
+*/
+
+#ifndef SLDRAWCOMMAND_H
+#define SLDRAWCOMMAND_H
+
+#include <SDL2/SDL.h>
+
+#include "SlSprite.h"
+
+
+/*! \struct SlDrawCommand
+
+  Copy of the data of one SlRenderItem, so that rendering can walk a contiguous array instead of following item, sprite, and destination pointers.
+  SlManager rebuilds its draw list when SlSprite::changeCount() shows that a destination or the render queue changed.
+*/
+struct SlDrawCommand
+{
+  /*! SlTexture::texture() of the sprite, nullptr if the item has no valid destination.
+   */
+  SDL_Texture* texture = nullptr;
+  /*! SlSprite::sourceRect_ .
+   */
+  SDL_Rect sourceRect = {0,0,0,0};
+  /*! Destination rectangle, colour, render options, and angle.
+   */
+  SlRenderSettings settings;
+  /*! SlSprite::boundingBox() of the destination.
+   */
+  SDL_Rect bounds = {0,0,0,0};
+  /*! True if the item hides what is below it, see SlManager::findOccluded().
+   */
+  bool isOccluder = false;
+  /*! SlRenderItem::renderMe_ , false as well if the destination is invalid.
+   */
+  bool renderMe = false;
+};
+
+
+#endif  /* SLDRAWCOMMAND_H */
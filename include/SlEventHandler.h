@@ -9,14 +9,30 @@
 #define  SLEVENTHANDLER_H
 
 #include <map>
+#include <memory>
 #include <vector>
 #include <string>
 
 #include <SDL2/SDL.h>
 
+#include "SlManipulation.h"
+
 
-class SlManipulation;
 class SlRenderItem;
+class SlFrameProfiler;
+class SlConfigReader;
+class SlSceneCache;
+
+
+/*! \enum SlMouseEvent
+  \brief The mouse events that can be bound in the configuration file as "mouse-down", "mouse-up", and "mouse-move".
+*/
+enum SlMouseEvent {
+  SL_MOUSE_DOWN = 0,
+  SL_MOUSE_UP,
+  SL_MOUSE_MOVE,
+  SL_MOUSE_COUNT
+};
 
 /*! \class SlEventAction
   This describes a single action that will be taken as a result of an input. 
@@ -26,9 +42,9 @@ class SlEventAction
  public:
   SlEventAction(){};
   ~SlEventAction();
-  /*! Calls the SlManipulation
+  /*! Calls SlManipulation::apply(). mouse is x, y, dx, dy of the current event or nullptr if the event has no mouse data.
    */
-  void act( std::vector<std::string> additionalParams );
+  void act(const int* mouse);
 
   /*! The manipulation object that handles the action.
    */
@@ -40,9 +56,9 @@ class SlEventAction
     Warning: have to think of something if one SlEventAction changes the destination number.
    */
   int destination = 0;
-  /*! The parameters with which the SlManipulation is called.
+  /*! The parameters with which the SlManipulation is called, numbers converted when the action is added.
    */
-  std::vector<std::string> parameters;
+  SlArguments arguments;
 };
 
 
@@ -64,9 +80,9 @@ class SlEventObject
   /*! Deleted, same reason as copy constructor.
    */
   SlEventObject& operator=(const SlEventObject&) = delete;
-  /*! Adds a new SlEventAction to #actions_.
+  /*! Adds a new SlEventAction to #actions_ and converts its numeric parameters with SlManipulation::prepareArguments().
    */
-  void addAction(std::string name, int destination, SlManipulation* manip, std::vector<std::string> params );
+  void addAction(const std::string& name, int destination, SlManipulation* manip, const std::vector<std::string>& params );
   /*! Triggers the SlEventAction::act() for all objects in #actions_.
    */
   void trigger(int mouse_x = -1, int mouse_y = -1);
@@ -103,7 +119,10 @@ class SlEventHandler
   /*! Deleted, same reason as copy constructor.
    */
   SlEventHandler& operator=(const SlEventHandler&) = delete;
-  /*! Creates the SlEventAction based on the parsed input. Creates SlEventObject if it doesn't exist.
+  /*! Creates the SlEventAction based on the parsed input. Creates SlEventObject if it doesn't exist.\n
+    "leftclick move" drags the named sprite, "leftclick pick" drags whichever item is topmost under the mouse (see SlRMpick), the sprite name is ignored and may be left out.\n
+    key is "leftclick", a SlMouseEvent keyword, or any key name known to SDL_GetKeyFromName() (case-insensitive, e.g. "up", "space", "a", "F1").
+    \throws std::invalid_argument if key or whatToDo are unknown.
    */
   void addAction(const std::string& key, const std::string& whatToDo, const std::string& spritename, int destination, std::vector<std::string> parameters );
   /*! Adds the given SlManipulations to #manipulations_.
@@ -113,32 +132,86 @@ class SlEventHandler
     \throws std::invalid_argument if not found.
    */
   SlManipulation* getManipulation(const std::string& whatToDo);
-  /*! The actual event handling, checking what SDL_Event was registered. Limited implimentation.
+  /*! The actual event handling, checking what SDL_Event was registered. Looks up the SlEventObject in #keyActions_ or #mouseActions_ .\n
+    Escape quits unless it is bound to an action.
     \retval 1 if event was quit.
     \retval 0 otherwise.
    */
   int handleEvent(const SDL_Event& event);
   /*! Parse configuration file entry.
-    Pattern: key   what      spritename     sprite_destination      parameters
+    Pattern: key   what      spritename     sprite_destination      parameters\n
+    Adds the bindings to scene if given, a binding that fails marks scene incomplete.
    */ 
-  void parseEvent(std::ifstream& input);
-  /*! Check for events. 
+  void parseEvent(SlConfigReader& input, SlSceneCache* scene = nullptr);
+  /*! Check for events. With motion coalescing on, all SDL_MOUSEMOTION events drained in one call are handled as one event with the last position and the summed movement.
+    The collected motion is handled before the next mouse button event and after the last event, so button and key events keep their order.
     \retval 1 if event was quit.
     \retval 0 otherwise.
    */
   int pollEvent();
+  /*! Blocks until an event arrives or timeout milliseconds have passed (no limit if timeout is negative), then handles all pending events.
+    \retval 1 if event was quit.
+    \retval 0 otherwise.
+   */
+  int waitEvent(int timeout);
+  /*! Turns coalescing of mouse motion events in pollEvent() and waitEvent() on or off. Off by default.
+   */
+  void setMotionCoalescing(bool coalesce){ coalesceMotion_ = coalesce; }
+  /*! Sets the profiler that times event handling (SL_PHASE_EVENTS) and the triggered manipulations (SL_PHASE_DISPATCH). Owned by SlManager.
+   */
+  void setProfiler(SlFrameProfiler* profiler){ profiler_ = profiler; }
+  /*! Pushes an event that ends waitEvent() and sets #redrawRequested. Can be called from other threads, e.g. SDL timer callbacks.
+   */
+  void wakeUp();
 
+  /*! Set when the window needs to be redrawn although no sprite changed: window exposed, shown, resized, or wakeUp() called. Reset by SlManager after rendering.
+   */
+  bool redrawRequested = false;
+  /*! Set when the renderer lost the contents of its render targets (SDL_RENDER_TARGETS_RESET, SDL_RENDER_DEVICE_RESET), also sets #redrawRequested. Reset by SlManager::render() after it dropped the cached layers and invalidated the dirty-rectangle canvas.
+   */
+  bool targetsReset = false;
   
  private:
-  /*! The string is the keyword for the event handling.
+  /*! Returns the SlEventObject for key, creating it if needed. The key name is resolved to a SDL_Scancode here, so handleEvent() only indexes a table.
+    \throws std::invalid_argument if key is unknown.
    */
-  std::map<std::string, SlEventObject> eventActions_;
+  SlEventObject& eventObject(const std::string& key);
+
+  /*! SlEventObjects for key presses indexed by SDL_Scancode, nullptr for unbound keys.
+   */
+  std::vector< std::unique_ptr<SlEventObject> > keyActions_;
+  /*! SlEventObjects for mouse events indexed by SlMouseEvent, nullptr if unbound.
+   */
+  std::unique_ptr<SlEventObject> mouseActions_[SL_MOUSE_COUNT];
   /*! Contains pointers to all SlSpriteManipulations and SlRenderManipulations
    */
   std::map<std::string, SlManipulation*> manipulations_;
+  /*! Adds the motion event to #motion_ , summing the relative movement.
+   */
+  void collectMotion(const SDL_Event& event);
+  /*! Handles #motion_ if #hasMotion_ is set.
+    \retval 1 if event was quit.
+   */
+  int flushMotion();
+
   /*! The event used for polling.
    */
   SDL_Event event_;
+  /*! Collect mouse motion events, see pollEvent().
+   */
+  bool coalesceMotion_ = false;
+  /*! Set if #motion_ holds motion that wasn't handled yet.
+   */
+  bool hasMotion_ = false;
+  /*! The coalesced motion event.
+   */
+  SDL_Event motion_;
+  /*! Event type registered for wakeUp().
+   */
+  uint32_t wakeUpEvent_ = 0;
+  /*! Times event handling if set.
+   */
+  SlFrameProfiler* profiler_ = nullptr;
 
 };
 
@@ -13,6 +13,8 @@
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_ttf.h>
 
+#include "SlSymbolTable.h"
+
 
 
 /*! \class SlFont for creating a texture from text.
@@ -39,7 +41,10 @@ class SlFont
   void loadFont(std::string fontfile, int fontsize);
   /*! The object name cannot be changed after instantiation.
    */
-  std::string name(){ return name_;}
+  const std::string& name() const { return name_;}
+  /*! SlSymbolTable ID of the name.
+   */
+  SlSymbol id() const {return id_;}
   /*! Returns the colour as a SDL_Color struct
    */
   SDL_Color sdlcolor();
@@ -60,6 +65,9 @@ class SlFont
   /*! The object name cannot be changed after instantiation.
    */
   std::string name_;
+  /*! #name_ interned in the SlSymbolTable.
+   */
+  SlSymbol id_;
 
 };
 
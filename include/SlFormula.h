@@ -0,0 +1,71 @@
+// part of SDL2lazy
+// author: Ulrike Hager
+
+/*! \file SlFormula.h
+ \brief SlFormula class, a formula from a configuration file compiled into a postfix program.
+*/
+
+#ifndef SLFORMULA_H
+#define SLFORMULA_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+
+/*! \class SlFormula
+  A formula like "SCREEN_WIDTH/2-10" compiled into Reverse Polish notation. Constant subexpressions are folded when compiling, SCREEN_WIDTH and SCREEN_HEIGHT stay as variables that are filled in by evaluate().\n
+  The program doesn't change after compile(), so a compiled formula can be evaluated any number of times and shared, see SlValueParser::compileFormula().
+ */
+class SlFormula
+{
+ public:
+  /*! Default constructor, empty program.
+   */
+  SlFormula(){}
+  /*! Compiles formula, which has no quotes and no whitespace, see compile().
+   */
+  SlFormula(const std::string& formula);
+  /*! Default destructor.
+   */
+  ~SlFormula(){}
+
+  /*! Compiles formula with the shunting-yard algorithm and folds constants. Replaces the previous program.
+    \throws std::runtime_error if the formula is malformed or contains a value that isn't a number, SCREEN_WIDTH or SCREEN_HEIGHT.
+   */
+  void compile(const std::string& formula);
+  /*! Runs the program with the given values for SCREEN_WIDTH and SCREEN_HEIGHT.
+   */
+  double evaluate(double width, double height) const;
+  /*! True if the program doesn't use SCREEN_WIDTH or SCREEN_HEIGHT, i.e. it was folded into a single constant.
+   */
+  bool isConstant() const {return ( program_.size() == 1 && program_[0].what == 'n' );}
+  /*! Number of instructions, 1 for a fully folded formula.
+   */
+  std::size_t size() const {return program_.size();}
+
+ private:
+  /*! One instruction: push a number ('n'), push value times SCREEN_WIDTH ('w') or SCREEN_HEIGHT ('h'), or apply the operator in what.
+   */
+  struct Instruction
+  {
+    char what;
+    double value;
+  };
+  /*! Appends an operator to #program_ , or replaces the last two instructions with their result if both are numbers.
+   */
+  void emit(char what);
+  /*! Result of the operator what applied to lhs and rhs.
+   */
+  static double apply(char what, double lhs, double rhs);
+
+  /*! The program in Reverse Polish notation.
+   */
+  std::vector<Instruction> program_;
+  /*! Largest number of values on the stack while running the program.
+   */
+  unsigned int depth_ = 0;
+};
+
+
+#endif  /* SLFORMULA_H */
@@ -0,0 +1,121 @@
+// part of SDL2lazy
+// author: Ulrike Hager
+
+/*! \file SlFrameProfiler.h
+  \brief SlFrameProfiler class and SlFramePhase enum, time the phases of the last frames.
+*/
+
+#ifndef SLFRAMEPROFILER_H
+#define SLFRAMEPROFILER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+/*! \enum SlFramePhase
+  \brief The parts of a frame timed by SlFrameProfiler.
+
+  SL_PHASE_EVENTS is the whole SlEventHandler::pollEvent() or SlEventHandler::waitEvent() call minus the time spent waiting, it includes SL_PHASE_DISPATCH, the time spent in the triggered SlManipulations.\n
+  SL_PHASE_RENDER is SlManager::render() up to SDL_RenderPresent, SL_PHASE_PRESENT is SDL_RenderPresent itself.\n
+  SL_PHASE_FRAME is the whole loop iteration including waiting for vsync or the frame limiter.
+*/
+enum SlFramePhase {
+  SL_PHASE_EVENTS = 0,
+  SL_PHASE_DISPATCH,
+  SL_PHASE_UPDATE,
+  SL_PHASE_RENDER,
+  SL_PHASE_PRESENT,
+  SL_PHASE_FRAME,
+  SL_PHASE_COUNT
+};
+
+
+/*! \struct SlPhaseStats
+
+  Percentiles of one SlFramePhase over the stored frames, in microseconds.
+*/
+struct SlPhaseStats
+{
+  double p50 = 0;
+  double p95 = 0;
+  double p99 = 0;
+  double max = 0;
+};
+
+
+/*! \class SlFrameProfiler
+  Timestamps the phases of each frame with SDL_GetPerformanceCounter() and keeps the last #capacity() frames in a ring buffer.\n
+  Time for a phase that happens several times per frame (e.g. SL_PHASE_DISPATCH) is added up. Does nothing until enabled with setCapacity().
+ */
+class SlFrameProfiler
+{
+ public:
+  /*! Default constructor, the profiler is disabled.
+   */
+  SlFrameProfiler();
+  /*! Default destructor.
+   */
+  ~SlFrameProfiler();
+
+  /*! Starts timing phase.
+   */
+  void begin(SlFramePhase phase);
+  /*! Starts a new frame in the ring buffer, overwriting the oldest one if it is full.
+   */
+  void beginFrame();
+  /*! Number of frames the ring buffer holds, 0 if disabled.
+   */
+  unsigned int capacity() const {return frames_.size();}
+  /*! Stops timing phase and adds the time to the current frame.
+   */
+  void end(SlFramePhase phase);
+  /*! Stores the time since beginFrame() as SL_PHASE_FRAME.
+   */
+  void endFrame();
+  /*! Number of frames stored, at most capacity().
+   */
+  unsigned int frames() const {return stored_;}
+  /*! True if capacity() > 0.
+   */
+  bool isEnabled() const {return !frames_.empty();}
+  /*! Name of phase as used in the CSV header.
+   */
+  static std::string phaseName(SlFramePhase phase);
+  /*! Resizes the ring buffer to frames and discards the stored frames. 0 disables the profiler.
+   */
+  void setCapacity(unsigned int frames);
+  /*! Returns p50, p95, p99, and max of phase over the stored frames.
+   */
+  SlPhaseStats stats(SlFramePhase phase) const;
+  /*! Writes one line per stored frame, oldest first, with the time of each phase in microseconds.
+    \retval false if the file can't be written.
+   */
+  bool writeCsv(const std::string& filename) const;
+
+ private:
+  /*! Converts performance counter ticks to microseconds.
+   */
+  double microseconds(uint64_t ticks) const;
+  /*! Ticks per phase for each frame.
+   */
+  std::vector< std::vector<uint64_t> > frames_;
+  /*! Position of the current frame in #frames_ .
+   */
+  unsigned int current_ = 0;
+  /*! Number of valid frames in #frames_ .
+   */
+  unsigned int stored_ = 0;
+  /*! Counter value at begin() for each phase.
+   */
+  uint64_t started_[SL_PHASE_COUNT] = {0};
+  /*! Counter value at beginFrame().
+   */
+  uint64_t frameStarted_ = 0;
+  /*! SDL_GetPerformanceFrequency().
+   */
+  uint64_t frequency_ = 1;
+};
+
+
+#endif  /* SLFRAMEPROFILER_H */
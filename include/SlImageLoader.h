@@ -0,0 +1,105 @@
+// part of SDL2lazy
+// author: Ulrike Hager
+
+/*! \file SlImageLoader.h
+ \brief SlImageLoader class, decodes image files on worker threads.
+*/
+
+#ifndef SLIMAGELOADER_H
+#define SLIMAGELOADER_H
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <SDL2/SDL.h>
+
+
+/*! \class SlImageLoader
+  Thread pool that decodes image files to SDL_Surfaces with IMG_Load ahead of time, so that the render thread only has to upload them.\n
+  prefetch() queues a file, take() hands the decoded surface to the caller, waiting for it if the decode hasn't finished. Files are decoded in the order they were queued.
+  The workers are started with the first prefetch() and never touch the renderer.
+ */
+class SlImageLoader
+{
+ public:
+  /*! Uses up to threads workers, 0 for one per hardware thread.
+   */
+  SlImageLoader(unsigned int threads = 0);
+  /*! Stops the workers and frees the surfaces that weren't taken.
+   */
+  ~SlImageLoader();
+  /*! Deleted, the loader owns its threads.
+   */
+  SlImageLoader(const SlImageLoader&) = delete;
+  /*! Deleted, the loader owns its threads.
+   */
+  SlImageLoader& operator=(const SlImageLoader&) = delete;
+
+  /*! Drops the queued files, waits for the running decodes and frees the surfaces that weren't taken.
+   */
+  void clear();
+  /*! Forgets filename: frees its surface if it was decoded, drops it from the queue, or frees the surface when the running decode finishes.
+   */
+  void drop(const std::string& filename);
+  /*! True if take() would return without waiting, i.e. filename was decoded or wasn't prefetched.
+   */
+  bool isReady(const std::string& filename);
+  /*! Queues filename for decoding, unless it is already queued or decoded.
+   */
+  void prefetch(const std::string& filename);
+  /*! Waits for the decode of filename if it was prefetched and hands over the surface, the caller frees it. isOpaque is the result of SlTexture::hasOnlyOpaquePixels() for the surface.
+    \retval false if filename wasn't prefetched, surface is unchanged.
+    \throws std::runtime_error if the image couldn't be decoded.
+   */
+  bool take(const std::string& filename, SDL_Surface*& surface, bool& isOpaque);
+
+ private:
+  /*! A decoded or queued file.
+   */
+  struct Image
+  {
+    SDL_Surface* surface = nullptr;
+    bool isOpaque = false;
+    bool isDone = false;
+    std::string error;
+  };
+  /*! Worker loop: decodes the files in #queue_ until the loader is destroyed.
+   */
+  void work();
+
+  /*! Guards all members below.
+   */
+  std::mutex mutex_;
+  /*! Signalled when a file is queued or the loader stops.
+   */
+  std::condition_variable queued_;
+  /*! Signalled when a decode finished.
+   */
+  std::condition_variable decoded_;
+  /*! Files waiting for a worker.
+   */
+  std::deque<std::string> queue_;
+  /*! Queued, running and finished decodes by file name.
+   */
+  std::unordered_map<std::string, Image> images_;
+  /*! Decodes running right now.
+   */
+  unsigned int busy_ = 0;
+  /*! Maximum number of workers.
+   */
+  unsigned int threadCount_;
+  /*! The workers.
+   */
+  std::vector<std::thread> workers_;
+  /*! Set by the destructor to end the workers.
+   */
+  bool isStopping_ = false;
+};
+
+
+#endif  /* SLIMAGELOADER_H */
@@ -0,0 +1,113 @@
+// part of SDL2lazy
+// author: Ulrike Hager
+
+/*! \file SlLayerCache.h
+  \brief SlLayerCache class, flattens runs of unchanged render queue items into cached render targets.
+*/
+
+#ifndef SLLAYERCACHE_H
+#define SLLAYERCACHE_H
+
+#include <vector>
+
+#include <SDL2/SDL.h>
+
+/*! SDL_ComposeCustomBlendMode was added in SDL 2.0.6. Without it only runs at the start of the render queue can be cached.
+ */
+#define SL_HAVE_CUSTOM_BLEND SDL_VERSION_ATLEAST(2,0,6)
+
+
+class SlRenderItem;
+class SlRenderState;
+
+
+/*! \class SlLayerCache
+  Finds runs of consecutive SlRenderItems whose SlRenderSettings::version hasn't changed for #staticFrames frames and renders each run into a window-sized target texture, so the whole run can be drawn with one SDL_RenderCopy.\n
+  A layer stays valid as long as the render queue holds the same items with the same versions at its position. Any change to one of its items, including render queue manipulations, drops the layer; it is rebuilt once the items are unchanged again.\n
+  A run at the start of the queue is rendered onto the clear colour and copied without blending. Other runs are rendered onto a transparent target, which gives premultiplied alpha, and copied with the matching custom blend mode.
+ */
+class SlLayerCache
+{
+ public:
+  /*! Default constructor.
+   */
+  SlLayerCache();
+  /*! Default destructor. Call clear() before the renderer is destroyed.
+   */
+  ~SlLayerCache();
+  /*! Delete copy constructor, the layers own SDL_Textures.
+   */
+  SlLayerCache(const SlLayerCache&) = delete;
+  /*! Deleted, same reason as copy constructor.
+   */
+  SlLayerCache& operator=(const SlLayerCache&) = delete;
+
+  /*! Destroys all layers.
+   */
+  void clear();
+  /*! Returns the layer texture if a layer starts at position in the render queue, nullptr otherwise.
+    \param length Set to the number of render queue items in the layer.
+    \param bounds Set to the part of the window that the layer's items cover.
+   */
+  SDL_Texture* layerAt(unsigned int position, unsigned int& length, SDL_Rect& bounds) const;
+  /*! Number of cached layers.
+   */
+  unsigned int layers() const {return layers_.size();}
+  /*! Drops the layers whose items changed and creates layers for new runs of unchanged items. Has to be called once per frame before rendering, with the window as render target.
+   */
+  void update(SDL_Renderer* renderer, SlRenderState& state, const std::vector<SlRenderItem*>& queue, int width, int height);
+  /*! Maximum number of layers, each one is a window-sized texture.
+   */
+  unsigned int maxLayers = 4;
+  /*! Shortest run of items that is worth a layer.
+   */
+  unsigned int minItems = 4;
+  /*! Number of frames an item has to stay unchanged before it is cached.
+   */
+  unsigned int staticFrames = 30;
+
+ private:
+  /*! An item rendered into a layer, and the state it was rendered in.
+   */
+  struct LayerItem
+  {
+    SlRenderItem* item;
+    unsigned long version;
+    bool renderMe;
+  };
+  /*! A cached run of items.
+   */
+  struct Layer
+  {
+    unsigned int first = 0;
+    std::vector<LayerItem> items;
+    SDL_Rect bounds = {0,0,0,0};
+    SDL_Texture* texture = nullptr;
+  };
+  /*! Renders the items from first to last (exclusive) into a new layer.
+    \retval false if the layer couldn't be created.
+   */
+  bool build(SDL_Renderer* renderer, SlRenderState& state, const std::vector<SlRenderItem*>& queue, unsigned int first, unsigned int last, int width, int height);
+  /*! Returns true if queue still holds the items of layer in the same state.
+   */
+  bool isValid(const Layer& layer, const std::vector<SlRenderItem*>& queue) const;
+  /*! Gets the SlRenderSettings::version of the item's destination.
+    \retval false if the destination doesn't exist.
+   */
+  static bool itemVersion(SlRenderItem* item, unsigned long& version);
+  /*! The cached layers.
+   */
+  std::vector<Layer> layers_;
+  /*! Index into #layers_ for each render queue position where a layer starts, -1 elsewhere.
+   */
+  std::vector<int> layerStart_;
+  /*! False after creating a target texture failed, no more layers are created.
+   */
+  bool canCreate_ = true;
+  /*! False if the renderer doesn't support the premultiplied alpha blend mode, only runs at the start of the queue are cached.
+   */
+  bool canBlend_ = true;
+};
+
+
+#endif  /* SLLAYERCACHE_H */
@@ -8,6 +8,7 @@
 #ifndef SLMANAGER_H
 #define SLMANAGER_H
 
+#include <functional>
 #include <memory>
 #include <string>
 #include <vector>
@@ -19,11 +20,21 @@
 #include "SlSpriteManager.h"
 #include "SlValueParser.h"
 #include "SlEventHandler.h"
+#include "SlRenderBatch.h"
+#include "SlRenderState.h"
+#include "SlDirtyRegion.h"
+#include "SlRenderStats.h"
+#include "SlLayerCache.h"
+#include "SlFrameProfiler.h"
+#include "SlDrawCommand.h"
+#include "SlRenderQueue.h"
 
 class SlTexture;
 class SlSprite;
 class SlRenderItem;
 class SlManipulation;
+class SlConfigReader;
+class SlSceneCache;
 
 
 class SlManager
@@ -63,6 +74,9 @@ class SlManager
    /*! Tells #tmngr_ to delete the specified texture and remove from SlTextureManager::textures_ . Also deletes all associates SlSprites.
    */
   void deleteTexture(const std::string& name);
+  /*! The screen areas changed since the last frame. Passed to every SlSprite by SlSpriteManager.
+   */
+  SlDirtyRegion* dirtyRegion(){return &dirtyRegion_;}
   /*! Returns pointer to the sprite, nullptr if not found. 
    */
   std::shared_ptr<SlSprite> findSprite(const std::string& name);
@@ -90,9 +104,23 @@ class SlManager
     append
    */
   void manipulateRenderQueue(const std::string& name, unsigned int destination, const std::string& whatToDo, const std::vector<std::string>& parameters );
-  /*! Add sprites to render queue, change to order of the queue. (Currently only implemented: append.)
+  /*! The topmost rendered SlRenderItem whose destination contains x, y, looked up in the SlSpatialGrid of the #renderQueue_ .
+    \retval nullptr if there is none.
+   */
+  SlRenderItem* pickAt(int x, int y);
+  /*! Times the phases of the last frames. Enable with SlFrameProfiler::setCapacity() or "profile frames [file.csv]" in SlApplication.ini.
+   */
+  SlFrameProfiler& profiler(){return profiler_;}
+  /*! Fraction of the fixed update step that has passed since the last update, between 0 and 1. Can be used to interpolate positions in the render phase.
+   */
+  double interpolation() const {return ( updateRate_ > 0 ? accumulator_ * updateRate_ : 0 );}
+  /*! Tells #tmngr_ to pack the small image textures into atlas pages of #atlasSize_ and moves the source rectangles of their sprites. Called at the end of parseIniFile(), call it after parseConfigurationFile() if SlApplication.ini isn't used.
+    \retval Number of textures that were moved into an atlas.
    */
-  void parseRenderQueueManipulation( std::ifstream& input );
+  unsigned int packTextures();
+  /*! Add sprites to render queue, change to order of the queue. Adds the applied operations to scene if given, one that fails marks scene incomplete.
+   */
+  void parseRenderQueueManipulation( SlConfigReader& input, SlSceneCache* scene = nullptr );
   /*! Read texture and sprite definitions from configuration file.\n
     Default file name: "SlTextures.ini".
    */
@@ -107,15 +135,67 @@ class SlManager
   /*! Temporary solution until all rendering related stuff happens in SlManager methods.
    */
   SDL_Renderer* renderer(){return renderer_;}
-  /*! Run the event - render loop.
+  /*! Counts of drawn and culled items in the last frame.
+   */
+  const SlRenderStats& renderStats() const {return renderStats_;}
+  /*! The texture state tracker used for all rendering. SlRenderState::issued() and SlRenderState::saved() count the texture state calls of the last frame.
+   */
+  SlRenderState& renderState(){return renderState_;}
+  /*! Sets the frame rate that run() limits itself to by sleeping when the renderer doesn't wait for vsync. 0 for no limit.
+   */
+  void setFrameRate(int fps){ targetFps_ = fps; }
+  /*! Sets the function called at a fixed rate from run() and runOnChange(). It gets the length of the step in seconds.
+   */
+  void setUpdateCallback(std::function<void(double)> update){ updateCallback_ = update; }
+  /*! Sets how often per second the update callback is called. If the loop falls behind by more than maxUpdates steps, the remaining steps are dropped.
+   */
+  void setUpdateRate(double rate, unsigned int maxUpdates = 5);
+  /*! Sets the width and height of the texture atlas pages used by packTextures(), 0 turns packing off. Textures loaded from files after this keep their decoded images for packTextures() if they fit on a page.
+   */
+  void setAtlasSize(int size);
+  /*! Turns batched rendering on or off. When on, consecutive SlRenderItems with the same SlTexture are drawn with a single SDL_RenderGeometry call (see SlRenderBatch).
+    \retval false if batching was requested but SDL is older than 2.0.18.
+   */
+  bool setBatchRendering(bool batch);
+  /*! Turns caching of unchanged render queue runs on or off, see SlLayerCache.
+   */
+  void setLayerCaching(bool layers);
+  /*! Turns coalescing of mouse motion events on or off, see SlEventHandler::pollEvent(). Off by default.
+   */
+  void setMotionCoalescing(bool coalesce);
+  /*! Turns the compiled scene cache on or off. When on, parseConfigurationFile() replays "file.slc" (see SlSceneCache) if it is newer than the configuration file and was written for the same window size, and writes it after parsing the text otherwise. Off by default.
+   */
+  void setSceneCaching(bool caching){ sceneCaching_ = caching; }
+  /*! Limits the memory of the resident textures to bytes, 0 for no limit. When over the budget, render() evicts the image file textures that were drawn least recently and reloads them from their file when a render queue item inside the window needs them again. Set in SlApplication.ini with "texturebudget megabytes".
+   */
+  void setTextureBudget(std::size_t bytes){ tmngr_->setTextureBudget(bytes); }
+  /*! Turns occlusion culling on or off, see findOccluded(). On by default.
+   */
+  void setOcclusionCulling(bool occlusion){ occlusionCulling_ = occlusion; }
+  /*! Turns dirty-rectangle rendering on or off. When on, the render queue is drawn into a texture that is kept between frames, and only the items intersecting the #dirtyRegion_ are redrawn.
+   */
+  void setDirtyRendering(bool dirty);
+  /*! Selects the run() loop. If onChange is true, run() only renders after something changed (see runOnChange()). 
+    The loop wakes up for events, wakeUp(), and at the latest after maxWait milliseconds (no limit if negative).
+   */
+  void setRunOnChange(bool onChange, int maxWait = -1);
+  /*! Run the event - update - render loop. Calls runOnChange() if #runOnChange_ is set.\n
+    Each frame handles the pending events, calls the update callback as often as the fixed update rate requires (see setUpdateRate()), and renders once. Without vsync the loop sleeps to keep to the frame rate set with setFrameRate().
    */
   void run();
+  /*! Event - render loop that sleeps in SDL_WaitEventTimeout and only renders if the #dirtyRegion_ isn't empty or the SlEventHandler requested a redraw.
+    If an update callback is set, it also wakes up for each update step.
+   */
+  void runOnChange();
   /*! Returns the #screen_width_ of the window.
    */
   int screenWidth(){ return screen_width_; }
   /*! Returns the #screen_height_ of the window.
    */
   int screenHeight(){ return screen_height_; }
+  /*! The SlSpatialGrid of the #renderQueue_ . Passed to every SlSprite by SlSpriteManager.
+   */
+  SlSpatialGrid* spatialGrid(){return renderQueue_.spatialGrid();}
   /*! Sets color for SlSprite name at position i of SlSprite::destinations_.
 
     Color is use when using color mod to render, and when creating a texture from a rectangle.
@@ -130,6 +210,13 @@ class SlManager
     \retval false if i > SlSprite::destinations_ size.
    */
   inline void setSpriteRenderOptions(const std::string& name, uint32_t renderOptions, unsigned int destination = 0);
+  /*! Swaps the textures loaded with "load async" whose images are decoded into their sprites, see SlTextureManager::streamTextures() and SlSprite::resizeSource(). Called by run() and runOnChange() at the start of each frame.
+    \retval Number of textures swapped in.
+   */
+  unsigned int streamTextures();
+  /*! Hit, miss and eviction counters of the texture budget, see setTextureBudget().
+   */
+  SlTextureStats& textureStats(){return tmngr_->textureStats();}
   /*! Replaces the sprite 'toRemove' in the #renderQueue_ with sprite 'toAdd' .
     \retval false if sprite not found or destination out of bounds.
    */ 
@@ -145,6 +232,9 @@ class SlManager
     onOrOff is -1 to toggle, 0 to turn off, 1 to turn on.
    */
   void toggleRender(const std::string& toToggle, unsigned int destination = 0, int onOrOff = -1);
+  /*! Makes runOnChange() render the next frame. Can be called from other threads or SDL timer callbacks to schedule work that isn't triggered by input.
+   */
+  void wakeUp();
   /*! Turns off rendering for the specified SlRenderItem in the #renderQueue_ .
    */
   inline void toggleRenderOff(const std::string& toToggle, unsigned int destination = 0);
@@ -173,11 +263,49 @@ class SlManager
     (Handle with care, currently no test for valid iterators beyond +1...)
    */
   bool moveInRenderQueue(const std::string& toMoveName, const std::string& targetName, unsigned int destToMove = 0, unsigned int targetDest = 0, int beforeOrAfter = 0);
+  /*! Rebuilds #drawList_ from the #renderQueue_ if SlSprite::changeCount() changed since the last build.
+   */
+  void compileDrawList();
+  /*! Back-to-front pass over the #drawList_ that fills #isOccluded_ for the items that are completely hidden inside area by a later item.
+    Only items whose SlTexture::isOpaque(), that aren't rotated, and that don't use SL_RENDER_ALPHAMOD hide others. Colour mod doesn't change alpha and is allowed.
+    \retval true if area is completely covered by one opaque item, so it doesn't have to be cleared.
+   */
+  bool findOccluded(const SDL_Rect& area);
+  /*! Position of the item for sprite name at destination in the #renderQueue_ .
+    \retval -1 if there is no such sprite or item.
+   */
+  int findInRenderQueue(const std::string& name, unsigned int destination);
+  /*! Renders the #drawList_ entries whose bounding box intersects clip, or the window if clip is nullptr. Uses #batch_ if #batchRendering_ is set.
+    Runs cached in #layers_ are drawn with one copy. Items outside the window are counted in SlRenderStats::culled, items marked in #isOccluded_ in SlRenderStats::occluded. Call findOccluded() for the same area first.
+   */
+  void renderItems(const SDL_Rect* clip = nullptr);
+  /*! Calls the update callback once for each full update step since the last call, at most #maxUpdates_ times.
+   */
+  void runUpdates();
+  /*! Copies a layer from #layers_ that holds length items starting at position in the #renderQueue_ , unless it is outside clip or all its items are occluded.
+   */
+  void renderLayer(SDL_Texture* layer, unsigned int position, unsigned int length, const SDL_Rect& bounds, const SDL_Rect* clip);
+  /*! Redraws the dirty parts of #canvas_ and copies it to the window.
+   */
+  void renderDirty();
+  /*! Creates the textures, fonts and sprites and applies the manipulations, render queue operations and event bindings recorded in scene, as parseConfigurationFile() would from the text.
+   */
+  void replayScene(SlSceneCache& scene);
+  /*! Touches the textures of the rendered items in the #renderQueue_ that are inside the window, reloading evicted ones, and evicts the unused ones over the budget. Called by render() after compileDrawList() if a texture budget is set.
+   */
+  void manageTextureBudget();
   
  private:
   /*! Holds the items to be rendered. The front of the queue is rendered first (background) the last element is rendered last (foreground).
+    Indexed by sprite and destination, see SlRenderQueue::find().
+   */
+  SlRenderQueue renderQueue_;
+  /*! One entry per #renderQueue_ item, in the same order. Rebuilt by compileDrawList().
    */
-  std::vector<SlRenderItem*> renderQueue_;
+  std::vector<SlDrawCommand> drawList_;
+  /*! SlSprite::changeCount() when #drawList_ was built.
+   */
+  unsigned long drawListVersion_ = 0;
   /*! Texture manager, creates, stores, deletes SlTexture objects.
    */
   std::unique_ptr<SlTextureManager> tmngr_  = nullptr;
@@ -200,6 +328,78 @@ class SlManager
     The map key is the name of the manipulation, which is also the keyword used in the configuration file, the mapped value is the object that will do the actual work.
    */
   std::map<std::string, SlManipulation*> renderManip_;
+  /*! Use #batch_ in render(). Set in SlApplication.ini with "batch 1".
+   */
+  bool batchRendering_ = false;
+  /*! Remembers texture colour mod, alpha mod, and blend mode so they are only set when changed.
+   */
+  SlRenderState renderState_;
+  /*! Counters for the last frame.
+   */
+  SlRenderStats renderStats_;
+  /*! Draw unchanged runs of the #renderQueue_ from #layers_ . Set in SlApplication.ini with "layers 1".
+   */
+  bool layerCaching_ = false;
+  /*! Cached render targets for runs of unchanged items.
+   */
+  SlLayerCache layers_;
+  /*! Load configuration files from their SlSceneCache when it is up to date. Set in SlApplication.ini with "scenecache 1", before the "file" lines.
+   */
+  bool sceneCaching_ = false;
+  /*! Use findOccluded() to skip hidden items. Set in SlApplication.ini with "occlusion 0|1".
+   */
+  bool occlusionCulling_ = true;
+  /*! Set by findOccluded() for each position in the #renderQueue_ .
+   */
+  std::vector<bool> isOccluded_;
+  /*! Collects the vertices for batched rendering.
+   */
+  std::unique_ptr<SlRenderBatch> batch_ = nullptr;
+  /*! Use renderDirty() in render(). Set in SlApplication.ini with "dirty 1".
+   */
+  bool dirtyRendering_ = false;
+  /*! Screen areas that changed since the last frame.
+   */
+  SlDirtyRegion dirtyRegion_;
+  /*! Render target that holds the last frame for dirty-rectangle rendering.
+   */
+  SDL_Texture* canvas_ = nullptr;
+  /*! run() calls runOnChange(). Set in SlApplication.ini with "onchange 1 [maxWait]".
+   */
+  bool runOnChange_ = false;
+  /*! Longest time in ms that runOnChange() waits for an event, negative for no limit.
+   */
+  int maxWait_ = -1;
+  /*! Called with the step length in seconds at the fixed #updateRate_ .
+   */
+  std::function<void(double)> updateCallback_;
+  /*! Update steps per second. Set in SlApplication.ini with "updaterate rate [maxUpdates]".
+   */
+  double updateRate_ = 60;
+  /*! Maximum number of update steps per frame, if the loop falls further behind the rest is dropped.
+   */
+  unsigned int maxUpdates_ = 5;
+  /*! Time in seconds that hasn't been used up by update steps yet.
+   */
+  double accumulator_ = 0;
+  /*! SDL_GetPerformanceCounter() at the last runUpdates().
+   */
+  uint64_t lastTick_ = 0;
+  /*! Frame rate limit for run() if the renderer has no vsync, 0 for no limit. Set in SlApplication.ini with "fps rate".
+   */
+  int targetFps_ = 60;
+  /*! True if SDL_RenderPresent waits for vsync, then run() doesn't sleep.
+   */
+  bool hasVsync_ = false;
+  /*! Frame phase timing.
+   */
+  SlFrameProfiler profiler_;
+  /*! If not empty, the profiled frames are written to this CSV file when the SlManager is destroyed.
+   */
+  std::string profileFile_;
+  /*! Size of the texture atlas pages, 0 to not pack textures. Set in SlApplication.ini with "atlas size".
+   */
+  int atlasSize_ = 2048;
 
 };
 
@@ -19,6 +19,29 @@ class SlSprite;
 class SlValueParser;
 
 
+/*! \struct SlArguments
+  Parameters of a SlManipulation triggered by an event. Prepared once by SlManipulation::prepareArguments() when the event is parsed, so triggering it doesn't convert strings.
+*/
+struct SlArguments
+{
+  /*! The parameters as given in the configuration file.
+   */
+  std::vector<std::string> parameters;
+  /*! One entry per parameter, the value from SlValueParser::doubleFromString() if isNumber is set for it.
+   */
+  std::vector<double> numbers;
+  /*! Marks the entries of #numbers that are valid.
+   */
+  std::vector<bool> isNumber;
+  /*! Set if #mouse holds the data of the current event.
+   */
+  bool hasMouse = false;
+  /*! Mouse x, y, and movement dx, dy since the previous event.
+   */
+  int mouse[4] = {-1, -1, 0, 0};
+};
+
+
 class SlManipulation
 {
  public:
@@ -35,14 +58,25 @@ class SlManipulation
   /*! The actual sprite manipulation, implemented in the derived classes.
    */
   virtual void manipulate(const std::string& name, unsigned int destination, const std::vector<std::string>& parameters);
+  /*! Typed manipulation used by SlEventHandler. The default converts the mouse data to strings, appends them to the parameters and calls manipulate().\n
+    Manipulations that are triggered by mouse motion override this and read SlArguments::mouse and SlArguments::numbers directly.
+   */
+  virtual void apply(const std::string& name, unsigned int destination, const SlArguments& arguments);
+  /*! Copies the first length mouse values, or if there is no mouse data the first length numeric parameters, to values.
+    \retval false if neither is available.
+   */
+  static bool coordinates(const SlArguments& arguments, int* values, unsigned int length);
   /*! Name can be read but not set. It is defined by the function that the derived class implements so that the correct derived class can be called based on a keyword.
    */
-  std::string name() {return name_;}
+  const std::string& name() const {return name_;}
   /*! Checks the existence of the named sprite and the validity of the destinations.
     \retval sprite of that name if name and destination valid.
     \throws std::invalid_argument if invalid name or destination.
    */
   std::shared_ptr<SlSprite> verifySprite(const std::string& name, unsigned int destination);
+  /*! Replaces the quoted formulas in SlArguments::parameters by their values, then fills SlArguments::numbers from the parameters with #valParser .
+   */
+  void prepareArguments(SlArguments& arguments);
   /*! Helper class to translate strings read from file into integers
    */
   SlValueParser* valParser = nullptr;
@@ -0,0 +1,101 @@
+// part of SDL2lazy
+// author: Ulrike Hager
+
+/*! \file SlRenderBatch.h
+  \brief SlRenderBatch class, collects textured quads that share a texture and submits them with a single SDL_RenderGeometry call.
+*/
+
+#ifndef SLRENDERBATCH_H
+#define SLRENDERBATCH_H
+
+#include <vector>
+
+#include <SDL2/SDL.h>
+
+#include "SlSprite.h"
+
+/*! SDL_RenderGeometry was added in SDL 2.0.18. Without it SlManager falls back to one SDL_RenderCopyEx per SlRenderItem.
+ */
+#define SL_HAVE_RENDER_GEOMETRY SDL_VERSION_ATLEAST(2,0,18)
+
+
+class SlTexture;
+class SlRenderState;
+
+
+/*! \class SlRenderBatch
+  Collects the vertices of consecutive sprite destinations that use the same SDL_Texture and blend mode. SlTextures packed into the same atlas page share one batch. Destinations with and without alpha mod share a batch if the texture blends anyway.\n
+  Rotation (SlRenderSettings::angle), colour mod and alpha mod are baked into the vertices, so the whole batch is drawn by one SDL_RenderGeometry call.
+  Adding a quad with a different texture or blend mode flushes the current batch first, so the painter's order of the render queue is kept.
+ */
+class SlRenderBatch
+{
+ public:
+  /*! Constructor. The texture state for each batch is set through state.
+   */
+  SlRenderBatch(SlRenderState* state);
+  /*! Default destructor.
+   */
+  ~SlRenderBatch();
+  /*! Delete copy constructor. A batch holds state that is only valid during one frame.
+   */
+  SlRenderBatch(const SlRenderBatch&) = delete;
+  /*! Deleted, same reason as copy constructor.
+   */
+  SlRenderBatch& operator=(const SlRenderBatch&) = delete;
+
+  /*! Adds the quad of sourceRect in texture rendered with settings. Calls flush() first if texture or blend mode don't match the current batch.
+    \throws std::runtime_error if the batch has to be flushed and can't be rendered.
+   */
+  void add(SDL_Renderer* renderer, SDL_Texture* texture, const SDL_Rect& sourceRect, const SlRenderSettings& settings);
+  /*! Number of SDL_RenderGeometry calls since the last resetCounters().
+   */
+  unsigned int drawCalls() const {return drawCalls_;}
+  /*! Renders all collected quads and empties the batch. The next add() starts a new batch even with the same texture.
+    \throws std::runtime_error if SDL_RenderGeometry fails.
+   */
+  void flush(SDL_Renderer* renderer);
+  /*! Number of quads since the last resetCounters().
+   */
+  unsigned int quads() const {return quads_;}
+  /*! Sets #drawCalls_ and #quads_ to 0.
+   */
+  void resetCounters();
+
+ protected:
+  /*! Default constructor, batches need a SlRenderState.
+   */
+  SlRenderBatch();
+
+ private:
+  /*! Sets colour mod, alpha mod, and blend mode for the batches. Owned by SlManager.
+   */
+  SlRenderState* state_ = nullptr;
+  /*! The texture of the current batch.
+   */
+  SDL_Texture* texture_ = nullptr;
+  /*! Blend mode of the current batch: SDL_BLENDMODE_BLEND for SL_RENDER_ALPHAMOD, otherwise the texture's default.
+   */
+  SDL_BlendMode blendMode_ = SDL_BLENDMODE_NONE;
+  /*! Width of the SDL_Texture, needed to normalize the texture coordinates.
+   */
+  float textureWidth_ = 1;
+  /*! Height of the SDL_Texture, needed to normalize the texture coordinates.
+   */
+  float textureHeight_ = 1;
+  /*! Four vertices per quad.
+   */
+  std::vector<SDL_Vertex> vertices_;
+  /*! Six indices (two triangles) per quad.
+   */
+  std::vector<int> indices_;
+  /*! SDL_RenderGeometry calls.
+   */
+  unsigned int drawCalls_ = 0;
+  /*! Quads submitted.
+   */
+  unsigned int quads_ = 0;
+};
+
+
+#endif  /* SLRENDERBATCH_H */
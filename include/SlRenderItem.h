@@ -39,7 +39,7 @@ class SlRenderItem
    */
   bool operator==( const SlRenderItem& rhs)
   {
-    return ( (sprite_->name() == rhs.sprite_->name() ) &&
+    return ( (sprite_->id() == rhs.sprite_->id() ) &&
 	     (destination_    == rhs.destination_    ) );
   }
   /*! SlRenderItems are equal when they have the same name and destination, i.e. the same sprite will be plotted in the same position.
@@ -55,9 +55,12 @@ class SlRenderItem
   /*! Checks if the provided coordinates are inside the destination of this render item.
    */
   bool is_inside(const int& x, const int& y);
+  /*! Marks the destination of this item as changed, see SlSprite::markDirty().
+   */
+  void markDirty() {sprite_->markDirty(destination_);}
   /*! The name of the sprite.
    */
-  std::string name() {return sprite_->name();}
+  const std::string& name() const {return sprite_->name();}
 
   /*! The sprite that will be rendered.
    */
@@ -71,6 +74,12 @@ class SlRenderItem
  /*! Determines whether the item will be rendered. This avoids having to delete an item and create a new one each in the same position if a sprite is toggled on and off often.
    */
   bool renderMe_;
+  /*! SlRenderSettings::version of the destination when SlLayerCache::update() last looked at the item.
+   */
+  unsigned long seenVersion_ = 0;
+  /*! Number of frames in which #seenVersion_ didn't change, counted by SlLayerCache::update().
+   */
+  unsigned int unchangedFrames_ = 0;
 };
 
 
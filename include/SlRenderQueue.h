@@ -0,0 +1,146 @@
+// part of SDL2lazy
+// author: Ulrike Hager
+
+/*! \file SlRenderQueue.h
+  \brief SlRenderQueue class, the render queue with an index from sprite and destination to queue position.
+*/
+
+#ifndef SLRENDERQUEUE_H
+#define SLRENDERQUEUE_H
+
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+#include "SlSpatialGrid.h"
+
+class SlSprite;
+class SlRenderItem;
+
+
+/*! \class SlRenderQueue
+  Ordered list of SlRenderItem pointers. The front of the queue is rendered first (background) the last element is rendered last (foreground).\n
+  Keeps a hash index from (SlRenderItem::sprite_, SlRenderItem::destination_) to the position of the first item with that sprite and destination, so finding an item doesn't scan the queue.
+  Changes that shift items (insert(), erase(), move()) update the positions of the items behind the change.\n
+  Also holds the SlSpatialGrid for finding the item under the mouse with pick().\n
+  The queue doesn't own the items, whoever removes an item deletes it.
+ */
+class SlRenderQueue
+{
+ public:
+  /*! Iterator over the items.
+   */
+  typedef std::vector<SlRenderItem*>::const_iterator const_iterator;
+
+  /*! Default constructor, empty queue.
+   */
+  SlRenderQueue();
+  /*! Default destructor, doesn't delete the items.
+   */
+  ~SlRenderQueue();
+
+  /*! The item at position, throws std::out_of_range for invalid positions.
+   */
+  SlRenderItem* at(unsigned int position) const {return items_.at(position);}
+  /*! First item.
+   */
+  const_iterator begin() const {return items_.begin();}
+  /*! Removes all items from the queue without deleting them.
+   */
+  void clear();
+  /*! Number of items that render destination of sprite.
+   */
+  unsigned int count(const SlSprite* sprite, unsigned int destination) const;
+  /*! True if the queue holds no items.
+   */
+  bool empty() const {return items_.empty();}
+  /*! Past-the-end iterator.
+   */
+  const_iterator end() const {return items_.end();}
+  /*! Removes the item at position from the queue and returns it. The caller deletes the item.
+   */
+  SlRenderItem* erase(unsigned int position);
+  /*! Removes all items of sprite from the queue and returns them. The caller deletes the items.
+   */
+  std::vector<SlRenderItem*> eraseSprite(const SlSprite* sprite);
+  /*! Position of the first item that renders destination of sprite.
+    \retval -1 if there is no such item.
+   */
+  int find(const SlSprite* sprite, unsigned int destination) const;
+  /*! Inserts item before position, position == size() appends the item.
+   */
+  void insert(unsigned int position, SlRenderItem* item);
+  /*! The items in render order.
+   */
+  const std::vector<SlRenderItem*>& items() const {return items_;}
+  /*! Position of the topmost rendered item whose destination contains x, y, see SlSpatialGrid::pick().
+    \retval -1 if there is none.
+   */
+  int pick(int x, int y) {return grid_.pick(*this, x, y);}
+  /*! Position of the item selected with setPicked().
+    \retval -1 if nothing is picked or the item left the queue.
+   */
+  int picked() const;
+  /*! Moves the item at position toMove before (beforeOrAfter = 0) or after (beforeOrAfter = 1) the item at position target, see SlManager::moveInRenderQueue().
+    \retval false if toMove == target and nothing moved.
+   */
+  bool move(unsigned int toMove, unsigned int target, int beforeOrAfter);
+  /*! Appends item.
+   */
+  void push_back(SlRenderItem* item);
+  /*! Puts item at position and returns the item that was there. The caller deletes the old item.
+   */
+  SlRenderItem* replace(unsigned int position, SlRenderItem* item);
+  /*! Remembers the item at position as the picked one, e.g. the one dragged with the mouse. -1 clears it.
+   */
+  void setPicked(int position);
+  /*! The grid that SlSprite::markDirty() reports changes to.
+   */
+  SlSpatialGrid* spatialGrid() {return &grid_;}
+  /*! Number of items.
+   */
+  std::size_t size() const {return items_.size();}
+  /*! The item at position, no range check.
+   */
+  SlRenderItem* operator[](unsigned int position) const {return items_[position];}
+
+ private:
+  /*! Sprite and destination of an item.
+   */
+  typedef SlItemKey Key;
+  /*! Index entry: position of the first item with the key and number of items with the key.
+   */
+  struct Entry
+  {
+    unsigned int position;
+    unsigned int count;
+  };
+  /*! Key of item.
+   */
+  static Key keyOf(const SlRenderItem* item);
+  /*! Adds item, which is at position, to the #index_ .
+   */
+  void addToIndex(const SlRenderItem* item, unsigned int position);
+  /*! Removes item from the #index_ counts, doesn't touch positions.
+   */
+  void removeFromIndex(const SlRenderItem* item);
+  /*! Recomputes the positions in #index_ for the items from position on. Items before position must not have moved.
+   */
+  void reindex(unsigned int position);
+
+  /*! The queue.
+   */
+  std::vector<SlRenderItem*> items_;
+  /*! Maps sprite and destination to the first position in #items_ .
+   */
+  std::unordered_map<Key, Entry, SlItemKeyHash> index_;
+  /*! Spatial index over the items' destinations.
+   */
+  SlSpatialGrid grid_;
+  /*! Sprite and destination of the picked item, sprite is nullptr if none.
+   */
+  Key picked_ = Key(nullptr, 0);
+};
+
+
+#endif  /* SLRENDERQUEUE_H */
@@ -18,6 +18,7 @@
 
 
 class SlRenderItem;
+class SlRenderQueue;
 class SlSpriteManager;
 class SlSprite;
 
@@ -26,7 +27,7 @@ class SlRenderQueueManipulation : public SlManipulation
  public:
   /*! Use this constructor to set the required pointers. 
    */
-  SlRenderQueueManipulation(SlSpriteManager* smngr, SlValueParser* valPars, std::vector<SlRenderItem*>* renderQueue);
+  SlRenderQueueManipulation(SlSpriteManager* smngr, SlValueParser* valPars, SlRenderQueue* renderQueue);
   /*! Default destructor.
    */
   virtual ~SlRenderQueueManipulation();
@@ -34,6 +35,10 @@ class SlRenderQueueManipulation : public SlManipulation
   /*! Creates new SlRenderItem for the specified sprite. \n
    */ 
   SlRenderItem* createRenderItem(const std::string& name, unsigned int destination);
+  /*! Position of the item for sprite name at destination in the #renderQueue_ , looked up in the SlRenderQueue index.
+    \retval -1 if there is no such sprite or item.
+   */
+  int findInRenderQueue(const std::string& name, unsigned int destination);
   /*! The actual render queue manipulation, implemented in the derived classes.
    */
   virtual void manipulate(const std::string& name, unsigned int destination, const std::vector<std::string>& parameters);
@@ -45,7 +50,7 @@ class SlRenderQueueManipulation : public SlManipulation
  protected:
   /*! Holds the items to be rendered. The front of the queue is rendered first (background) the last element is rendered last (foreground).
    */
-  std::vector<SlRenderItem*>* renderQueue_;
+  SlRenderQueue* renderQueue_;
 
 
 };
@@ -57,7 +62,7 @@ class SlRenderQueueManipulation : public SlManipulation
 class SlRMappend : public SlRenderQueueManipulation
 {
  public:
-  SlRMappend(SlSpriteManager* smngr, SlValueParser* valPars, std::vector<SlRenderItem*>* renderQueue);
+  SlRMappend(SlSpriteManager* smngr, SlValueParser* valPars, SlRenderQueue* renderQueue);
   void manipulate(const std::string& name, unsigned int destination, const std::vector<std::string>& parameters) override;
 };
 
@@ -69,7 +74,7 @@ class SlRMappend : public SlRenderQueueManipulation
 class SlRMinsertAfter : public SlRenderQueueManipulation
 {
  public:
-  SlRMinsertAfter(SlSpriteManager* smngr, SlValueParser* valPars, std::vector<SlRenderItem*>* renderQueue);
+  SlRMinsertAfter(SlSpriteManager* smngr, SlValueParser* valPars, SlRenderQueue* renderQueue);
   void manipulate(const std::string& name, unsigned int destination, const std::vector<std::string>& parameters) override;
 };
 
@@ -81,7 +86,7 @@ class SlRMinsertAfter : public SlRenderQueueManipulation
 class SlRMinsertBefore : public SlRenderQueueManipulation
 {
  public:
-  SlRMinsertBefore(SlSpriteManager* smngr, SlValueParser* valPars, std::vector<SlRenderItem*>* renderQueue);
+  SlRMinsertBefore(SlSpriteManager* smngr, SlValueParser* valPars, SlRenderQueue* renderQueue);
   void manipulate(const std::string& name, unsigned int destination, const std::vector<std::string>& parameters) override;
 };
 
@@ -93,7 +98,7 @@ class SlRMinsertBefore : public SlRenderQueueManipulation
 class SlRMmoveAfter : public SlRenderQueueManipulation
 {
  public:
-  SlRMmoveAfter(SlSpriteManager* smngr, SlValueParser* valPars, std::vector<SlRenderItem*>* renderQueue);
+  SlRMmoveAfter(SlSpriteManager* smngr, SlValueParser* valPars, SlRenderQueue* renderQueue);
   void manipulate(const std::string& name, unsigned int destination, const std::vector<std::string>& parameters) override;
 };
 
@@ -105,7 +110,7 @@ class SlRMmoveAfter : public SlRenderQueueManipulation
 class SlRMmoveBefore : public SlRenderQueueManipulation
 {
  public:
-  SlRMmoveBefore(SlSpriteManager* smngr, SlValueParser* valPars, std::vector<SlRenderItem*>* renderQueue);
+  SlRMmoveBefore(SlSpriteManager* smngr, SlValueParser* valPars, SlRenderQueue* renderQueue);
   void manipulate(const std::string& name, unsigned int destination, const std::vector<std::string>& parameters) override;
 };
 
@@ -117,7 +122,7 @@ class SlRMmoveBefore : public SlRenderQueueManipulation
 class SlRMswapIn : public SlRenderQueueManipulation
 {
  public:
-  SlRMswapIn(SlSpriteManager* smngr, SlValueParser* valPars, std::vector<SlRenderItem*>* renderQueue);
+  SlRMswapIn(SlSpriteManager* smngr, SlValueParser* valPars, SlRenderQueue* renderQueue);
   void manipulate(const std::string& name, unsigned int destination, const std::vector<std::string>& parameters) override;
 };
 
@@ -130,7 +135,7 @@ class SlRMswapIn : public SlRenderQueueManipulation
 class SlRMtoggleOnOff : public SlRenderQueueManipulation
 {
  public:
-  SlRMtoggleOnOff(SlSpriteManager* smngr, SlValueParser* valPars, std::vector<SlRenderItem*>* renderQueue);
+  SlRMtoggleOnOff(SlSpriteManager* smngr, SlValueParser* valPars, SlRenderQueue* renderQueue);
   void manipulate(const std::string& name, unsigned int destination, const std::vector<std::string>& parameters) override;
 };
 
@@ -142,7 +147,7 @@ class SlRMtoggleOnOff : public SlRenderQueueManipulation
 class SlRMswapAt : public SlRenderQueueManipulation
 {
  public:
-  SlRMswapAt(SlSpriteManager* smngr, SlValueParser* valPars, std::vector<SlRenderItem*>* renderQueue);
+  SlRMswapAt(SlSpriteManager* smngr, SlValueParser* valPars, SlRenderQueue* renderQueue);
   void manipulate(const std::string& name, unsigned int destination, const std::vector<std::string>& parameters) override;
 };
 
@@ -154,7 +159,7 @@ class SlRMswapAt : public SlRenderQueueManipulation
 class SlRMactivate : public SlRenderQueueManipulation
 {
  public:
-  SlRMactivate(SlSpriteManager* smngr, SlValueParser* valPars, std::vector<SlRenderItem*>* renderQueue);
+  SlRMactivate(SlSpriteManager* smngr, SlValueParser* valPars, SlRenderQueue* renderQueue);
   void manipulate(const std::string& name, unsigned int destination, const std::vector<std::string>& parameters) override;
 };
 
@@ -166,7 +171,7 @@ class SlRMactivate : public SlRenderQueueManipulation
 class SlRMdeactivate : public SlRenderQueueManipulation
 {
  public:
-  SlRMdeactivate(SlSpriteManager* smngr, SlValueParser* valPars, std::vector<SlRenderItem*>* renderQueue);
+  SlRMdeactivate(SlSpriteManager* smngr, SlValueParser* valPars, SlRenderQueue* renderQueue);
   void manipulate(const std::string& name, unsigned int destination, const std::vector<std::string>& parameters) override;
 };
 
@@ -178,8 +183,11 @@ class SlRMdeactivate : public SlRenderQueueManipulation
 class SlRMactivateIfInside : public SlRenderQueueManipulation
 {
  public:
-  SlRMactivateIfInside(SlSpriteManager* smngr, SlValueParser* valPars, std::vector<SlRenderItem*>* renderQueue);
+  SlRMactivateIfInside(SlSpriteManager* smngr, SlValueParser* valPars, SlRenderQueue* renderQueue);
   void manipulate(const std::string& name, unsigned int destination, const std::vector<std::string>& parameters) override;
+  /*! Reads the coordinates from SlArguments::mouse or SlArguments::numbers without converting strings.
+   */
+  void apply(const std::string& name, unsigned int destination, const SlArguments& arguments) override;
 };
 
 
@@ -190,8 +198,11 @@ class SlRMactivateIfInside : public SlRenderQueueManipulation
 class SlRMdeactivateIfInside : public SlRenderQueueManipulation
 {
  public:
-  SlRMdeactivateIfInside(SlSpriteManager* smngr, SlValueParser* valPars, std::vector<SlRenderItem*>* renderQueue);
+  SlRMdeactivateIfInside(SlSpriteManager* smngr, SlValueParser* valPars, SlRenderQueue* renderQueue);
   void manipulate(const std::string& name, unsigned int destination, const std::vector<std::string>& parameters) override;
+  /*! Reads the coordinates from SlArguments::mouse or SlArguments::numbers without converting strings.
+   */
+  void apply(const std::string& name, unsigned int destination, const SlArguments& arguments) override;
 };
 
 
@@ -202,8 +213,11 @@ class SlRMdeactivateIfInside : public SlRenderQueueManipulation
 class SlRMmoveBy : public SlRenderQueueManipulation
 {
  public:
-  SlRMmoveBy(SlSpriteManager* smngr, SlValueParser* valPars, std::vector<SlRenderItem*>* renderQueue);
+  SlRMmoveBy(SlSpriteManager* smngr, SlValueParser* valPars, SlRenderQueue* renderQueue);
   void manipulate(const std::string& name, unsigned int destination, const std::vector<std::string>& parameters) override;
+  /*! Reads the coordinates from SlArguments::mouse or SlArguments::numbers without converting strings.
+   */
+  void apply(const std::string& name, unsigned int destination, const SlArguments& arguments) override;
 };
 
 
@@ -214,7 +228,56 @@ class SlRMmoveBy : public SlRenderQueueManipulation
 class SlRMmoveActiveBy : public SlRenderQueueManipulation
 {
  public:
-  SlRMmoveActiveBy(SlSpriteManager* smngr, SlValueParser* valPars, std::vector<SlRenderItem*>* renderQueue);
+  SlRMmoveActiveBy(SlSpriteManager* smngr, SlValueParser* valPars, SlRenderQueue* renderQueue);
+  void manipulate(const std::string& name, unsigned int destination, const std::vector<std::string>& parameters) override;
+  /*! Reads the coordinates from SlArguments::mouse or SlArguments::numbers without converting strings.
+   */
+  void apply(const std::string& name, unsigned int destination, const SlArguments& arguments) override;
+};
+
+
+
+/*! \class SlRMpick
+  Picks the topmost item under the given coordinates with SlRenderQueue::pick(), sets it active and remembers it with SlRenderQueue::setPicked(). Ignores name and destination.
+ */
+class SlRMpick : public SlRenderQueueManipulation
+{
+ public:
+  SlRMpick(SlSpriteManager* smngr, SlValueParser* valPars, SlRenderQueue* renderQueue);
+  void manipulate(const std::string& name, unsigned int destination, const std::vector<std::string>& parameters) override;
+  /*! Reads the coordinates from SlArguments::mouse or SlArguments::numbers without converting strings.
+   */
+  void apply(const std::string& name, unsigned int destination, const SlArguments& arguments) override;
+ private:
+  /*! Picks the item at x, y.
+   */
+  void pick(int x, int y);
+};
+
+
+
+/*! \class SlRMmovePickedBy
+  Moves the destination of the item picked by SlRMpick by the given offset values. Ignores name and destination.
+ */
+class SlRMmovePickedBy : public SlRenderQueueManipulation
+{
+ public:
+  SlRMmovePickedBy(SlSpriteManager* smngr, SlValueParser* valPars, SlRenderQueue* renderQueue);
+  void manipulate(const std::string& name, unsigned int destination, const std::vector<std::string>& parameters) override;
+  /*! Reads the coordinates from SlArguments::mouse or SlArguments::numbers without converting strings.
+   */
+  void apply(const std::string& name, unsigned int destination, const SlArguments& arguments) override;
+};
+
+
+
+/*! \class SlRMdrop
+  Deactivates the item picked by SlRMpick and clears the pick. Ignores name and destination.
+ */
+class SlRMdrop : public SlRenderQueueManipulation
+{
+ public:
+  SlRMdrop(SlSpriteManager* smngr, SlValueParser* valPars, SlRenderQueue* renderQueue);
   void manipulate(const std::string& name, unsigned int destination, const std::vector<std::string>& parameters) override;
 };
 
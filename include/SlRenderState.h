@@ -0,0 +1,104 @@
+// part of SDL2lazy
+// author: Ulrike Hager
+
+/*! \file SlRenderState.h
+  \brief SlRenderState class, remembers colour mod, alpha mod and blend mode of each SDL_Texture to skip redundant SDL calls.
+*/
+
+#ifndef SLRENDERSTATE_H
+#define SLRENDERSTATE_H
+
+#include <cstdint>
+#include <unordered_map>
+
+#include <SDL2/SDL.h>
+
+
+struct SlRenderSettings;
+
+
+/*! \class SlRenderState
+  Tracks the colour mod, alpha mod and blend mode last applied to each SDL_Texture and only calls SDL_SetTextureColorMod, SDL_SetTextureAlphaMod, SDL_SetTextureBlendMode if the value changes.\n
+  A texture that hasn't been seen before is assumed to be unmodulated with the blend mode it was created with. This only holds if all texture state changes go through the SlRenderState owned by SlManager.
+ */
+class SlRenderState
+{
+ public:
+  /*! Default constructor.
+   */
+  SlRenderState();
+  /*! Default destructor.
+   */
+  ~SlRenderState();
+
+  /*! Sets the texture state requested by settings: colour mod for SL_RENDER_COLORMOD, alpha mod and SDL_BLENDMODE_BLEND for SL_RENDER_ALPHAMOD. Without these options the texture is reset to no mod and its default blend mode.
+   */
+  void apply(SDL_Texture* texture, const SlRenderSettings& settings);
+  /*! Resets the per-frame counters. Called by SlManager at the start of each frame.
+   */
+  void beginFrame();
+  /*! Blend mode of the texture when first seen by this object.
+   */
+  SDL_BlendMode defaultBlendMode(SDL_Texture* texture);
+  /*! Removes the texture from #states_ . Must be called before the SDL_Texture is destroyed, the pointer may be reused by SDL.
+   */
+  void forget(SDL_Texture* texture);
+  /*! SDL calls made in the current frame.
+   */
+  unsigned int issued() const {return issued_;}
+  /*! SDL calls skipped in the current frame because the value was already set.
+   */
+  unsigned int saved() const {return saved_;}
+  /*! Sets alpha mod if different from the current value.
+   */
+  void setAlphaMod(SDL_Texture* texture, uint8_t alpha);
+  /*! Sets blend mode if different from the current value.
+   */
+  void setBlendMode(SDL_Texture* texture, SDL_BlendMode blendMode);
+  /*! Sets colour mod if different from the current value.
+   */
+  void setColorMod(SDL_Texture* texture, uint8_t red, uint8_t green, uint8_t blue);
+  /*! SDL calls made since the object was created.
+   */
+  unsigned long totalIssued() const {return totalIssued_;}
+  /*! SDL calls skipped since the object was created.
+   */
+  unsigned long totalSaved() const {return totalSaved_;}
+
+ private:
+  /*! \struct TextureState
+    The values last set for one SDL_Texture.
+   */
+  struct TextureState
+  {
+    uint8_t color[3] = {0xFF, 0xFF, 0xFF};
+    uint8_t alpha = 0xFF;
+    SDL_BlendMode blendMode = SDL_BLENDMODE_NONE;
+    SDL_BlendMode defaultBlendMode = SDL_BLENDMODE_NONE;
+  };
+  /*! Returns the entry for the texture, creates it with the texture's current blend mode if it doesn't exist.
+   */
+  TextureState& state(SDL_Texture* texture);
+  /*! Counts a call that was made (true) or skipped (false).
+   */
+  void count(bool isIssued);
+
+  /*! Known state of every texture seen so far.
+   */
+  std::unordered_map<SDL_Texture*, TextureState> states_;
+  /*! SDL calls in the current frame.
+   */
+  unsigned int issued_ = 0;
+  /*! Skipped SDL calls in the current frame.
+   */
+  unsigned int saved_ = 0;
+  /*! SDL calls since creation.
+   */
+  unsigned long totalIssued_ = 0;
+  /*! Skipped SDL calls since creation.
+   */
+  unsigned long totalSaved_ = 0;
+};
+
+
+#endif  /* SLRENDERSTATE_H */
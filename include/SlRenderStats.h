@@ -0,0 +1,51 @@
+// part of SDL2lazy
+// author: Ulrike Hager
+
+/*! \file SlRenderStats.h
+  \brief SlRenderStats struct, counts what happened to the render queue items in the last frame.
+*/
+
+#ifndef SLRENDERSTATS_H
+#define SLRENDERSTATS_H
+
+
+/*! \struct SlRenderStats
+
+  Per-frame counters filled by SlManager::render(). Reset at the start of each frame.
+  With dirty-rectangle rendering an item is counted once for each dirty rectangle it is drawn in.
+*/
+struct SlRenderStats
+{
+  /*! Items passed to SlSprite::render() or SlSprite::addToBatch().
+   */
+  unsigned int drawn = 0;
+  /*! Items skipped because their bounding box is outside the window.
+   */
+  unsigned int culled = 0;
+  /*! Items skipped because an opaque item later in the render queue covers them.
+   */
+  unsigned int occluded = 0;
+  /*! Cached layers copied to the window, see SlLayerCache.
+   */
+  unsigned int layers = 0;
+  /*! Items in the copied layers, they aren't counted as drawn.
+   */
+  unsigned int cached = 0;
+  /*! SDL_RenderCopyEx, SDL_RenderGeometry, and layer copy calls, not counting clearing and copying the dirty-rectangle canvas.
+   */
+  unsigned int drawCalls = 0;
+  /*! Sets all counters to 0.
+   */
+  void reset()
+  {
+    drawCalls = 0;
+    drawn = 0;
+    culled = 0;
+    occluded = 0;
+    layers = 0;
+    cached = 0;
+  }
+};
+
+
+#endif  /* SLRENDERSTATS_H */
@@ -0,0 +1,138 @@
+// part of SDL2lazy
+// author: Ulrike Hager
+
+/*! \file SlSceneCache.h
+ \brief SlSceneCache class, compiled binary form of a configuration file. SlSceneOp enum for the recorded operations.
+*/
+
+#ifndef SLSCENECACHE_H
+#define SLSCENECACHE_H
+
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+
+/*! \enum SlSceneOp
+  Operations recorded in a SlSceneCache. Strings and numbers are listed in the order of the arguments of the function that replays the operation.
+ */
+enum SlSceneOp
+{
+  SL_SCENE_TEXTURE_FILE = 1,           //!< name, file
+  SL_SCENE_TEXTURE_TILE,               //!< name, sprite; width, height
+  SL_SCENE_TEXTURE_RECTANGLE,          //!< name; width, height, red, green, blue, alpha
+  SL_SCENE_TEXTURE_SPRITE_ON_TEXTURE,  //!< name, texture, sprite
+  SL_SCENE_TEXTURE_TEXT,               //!< name, font, message; width
+  SL_SCENE_FONT,                       //!< name, file; size, red, green, blue, alpha
+  SL_SCENE_SPRITE,                     //!< name, texture; x, y, width, height
+  SL_SCENE_SPRITE_MANIPULATION,        //!< name, whatToDo; destination; parameters
+  SL_SCENE_RENDERQUEUE,                //!< name, whatToDo; destination; parameters
+  SL_SCENE_EVENT,                      //!< key, whatToDo, spritename; destination; parameters
+  SL_SCENE_TEXTURE_ASYNC,              //!< name, file
+};
+
+
+/*! \class SlSceneCache
+  The resolved contents of a configuration file: the textures, fonts and sprites it creates, the manipulations and render queue operations it applies and the events it binds, in file order, with formulas evaluated.\n
+  While SlManager::parseConfigurationFile() parses the text, the section parsers add() one record per successful operation and markIncomplete() when an operation fails, e.g. because an image or font file is missing, so that the next parse tries it again. write() saves the records next to the configuration file, read() loads them back with a single read. The file stores the configuration file's size and modification time and the window size the formulas were evaluated for, read() rejects the file if any of them changed.\n
+  File layout, all 32-bit words in native byte order: header (see read()), string table (length, then the characters padded to a word), records (one word with op and the string, number and list counts, then the string indices, the numbers and the list's string indices).
+ */
+class SlSceneCache
+{
+ public:
+  /*! One operation, points into the loaded file.
+   */
+  struct Record
+  {
+    SlSceneOp op;
+    const uint32_t* strings;
+    unsigned int stringCount;
+    const uint32_t* numbers;
+    unsigned int numberCount;
+    const uint32_t* list;
+    unsigned int listCount;
+  };
+
+  /*! Default constructor, no records.
+   */
+  SlSceneCache(){}
+  /*! Default destructor.
+   */
+  ~SlSceneCache(){}
+
+  /*! Appends a record. list holds the parameters of manipulations and events.
+    \retval false if a count doesn't fit the record header, the cache is then not written.
+   */
+  bool add(SlSceneOp op, std::initializer_list<std::string_view> strings, std::initializer_list<int> numbers, const std::vector<std::string>& list = std::vector<std::string>());
+  /*! Moves to the next record after read().
+    \retval false after the last record.
+   */
+  bool next(Record& record);
+  /*! Integer i of record.
+   */
+  int number(const Record& record, unsigned int i) const {return static_cast<int32_t>( record.numbers[i] );}
+  /*! The list of record as strings.
+   */
+  std::vector<std::string> list(const Record& record) const;
+  /*! Called by the section parsers when an operation fails, write() then doesn't save the cache.
+   */
+  void markIncomplete(){ isComplete_ = false; }
+  /*! Loads filename if it was written for source at the given window size by this version.
+    \retval false if the file doesn't exist, is damaged or stale.
+   */
+  bool read(const std::string& filename, const std::string& source, int width, int height);
+  /*! String i of record.
+   */
+  const std::string& string(const Record& record, unsigned int i) const {return strings_[ record.strings[i] ];}
+  /*! Starts over with the first record for next().
+   */
+  void rewind(){ cursor_ = 0; }
+  /*! Writes the records to filename, stamped with the size and modification time of source and the window size.
+    \retval false if the file couldn't be written, a record didn't fit or an operation failed.
+   */
+  bool write(const std::string& filename, const std::string& source, int width, int height) const;
+
+  /*! File format version, files of other versions are stale.
+   */
+  static const uint32_t version = 2;
+
+ private:
+  /*! True if record has the strings and numbers its op needs.
+   */
+  static bool fits(const Record& record);
+  /*! Removes all strings and records.
+   */
+  void clear();
+  /*! Does the work of read(), may leave a partly loaded file behind when it fails.
+   */
+  bool load(const std::string& filename, const std::string& source, int width, int height);
+  /*! Size and modification time of source, the time in nanoseconds so that edits within the same second are noticed.
+    \retval false if source doesn't exist.
+   */
+  static bool stamp(const std::string& source, uint64_t& size, uint64_t& time);
+  /*! Index of value in #strings_ , adds it if needed.
+   */
+  uint32_t intern(std::string_view value);
+
+  /*! Strings used by the records, each stored once.
+   */
+  std::vector<std::string> strings_;
+  /*! Index of each string in #strings_ , used when recording.
+   */
+  std::unordered_map<std::string, uint32_t> stringIndex_;
+  /*! The records as written to the file.
+   */
+  std::vector<uint32_t> records_;
+  /*! Next word of #records_ for next().
+   */
+  std::size_t cursor_ = 0;
+  /*! False if a record didn't fit or an operation failed, see markIncomplete().
+   */
+  bool isComplete_ = true;
+};
+
+
+#endif  /* SLSCENECACHE_H */
@@ -0,0 +1,118 @@
+// part of SDL2lazy
+// author: Ulrike Hager
+
+/*! \file SlSpatialGrid.h
+  \brief SlSpatialGrid class, uniform grid over the render queue destinations for finding the item under the mouse. SlItemKey for identifying render queue items.
+*/
+
+#ifndef SLSPATIALGRID_H
+#define SLSPATIALGRID_H
+
+#include <cstddef>
+#include <functional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <SDL2/SDL.h>
+
+class SlSprite;
+class SlRenderQueue;
+
+
+/*! Sprite and destination of a SlRenderItem.
+ */
+typedef std::pair<const SlSprite*, unsigned int> SlItemKey;
+
+/*! \struct SlItemKeyHash
+  Hash for SlItemKey.
+*/
+struct SlItemKeyHash
+{
+  std::size_t operator()(const SlItemKey& key) const
+  {
+    return std::hash<const SlSprite*>()(key.first) ^ ( std::hash<unsigned int>()(key.second) * 0x9E3779B9u );
+  }
+};
+
+
+/*! \class SlSpatialGrid
+  Divides the window into square cells of #cellSize pixels, each cell lists the render queue items whose SlSprite::boundingBox() overlaps it. Items outside the window are listed in the border cells.\n
+  SlSprite::markDirty() reports changed destinations with touch(), SlRenderQueue reports items it adds and removes. The grid moves only those items before the next pick().
+  The grid is built on the first pick(), until then touch() does nothing.
+ */
+class SlSpatialGrid
+{
+ public:
+  /*! Default constructor, empty grid.
+   */
+  SlSpatialGrid();
+  /*! Default destructor.
+   */
+  ~SlSpatialGrid();
+
+  /*! Removes all items. The grid is rebuilt on the next pick().
+   */
+  void clear();
+  /*! Position in queue of the topmost (last rendered) item that is rendered and contains x, y.
+    \retval -1 if there is none.
+   */
+  int pick(const SlRenderQueue& queue, int x, int y);
+  /*! Sets the area covered by the cells, normally the window, and clears the grid.
+   */
+  void setBounds(int width, int height);
+  /*! Notes that destination of sprite changed or was added to or removed from the queue.
+   */
+  void touch(const SlSprite* sprite, unsigned int destination);
+
+  /*! Width and height of a cell in pixels. Takes effect with the next setBounds().
+   */
+  int cellSize = 64;
+
+ private:
+  /*! Cells covered by an item.
+   */
+  struct Entry
+  {
+    int first[2] = {0, 0};
+    int last[2] = {-1, -1};
+    bool isPending = false;
+  };
+  /*! Adds key to the cells of entry.
+   */
+  void addToCells(const SlItemKey& key, const Entry& entry);
+  /*! Sets the cell range of entry from rect.
+   */
+  void cellRange(const SDL_Rect& rect, Entry& entry) const;
+  /*! Cell column or row of coordinate, clamped to the grid.
+   */
+  int cellOf(int coordinate, int cells) const;
+  /*! Fills the grid with all items of queue.
+   */
+  void rebuild(const SlRenderQueue& queue);
+  /*! Removes key from the cells of entry.
+   */
+  void removeFromCells(const SlItemKey& key, const Entry& entry);
+  /*! Moves the items in #pending_ to their current cells, removes the ones that are no longer in queue.
+   */
+  void update(const SlRenderQueue& queue);
+
+  /*! Number of cell columns and rows.
+   */
+  int cells_[2] = {1, 1};
+  /*! Items per cell, row by row.
+   */
+  std::vector< std::vector<SlItemKey> > grid_;
+  /*! Cell range of each item in the grid.
+   */
+  std::unordered_map<SlItemKey, Entry, SlItemKeyHash> entries_;
+  /*! Items touched since the last update().
+   */
+  std::vector<SlItemKey> pending_;
+  /*! Set once the grid was built.
+   */
+  bool isBuilt_ = false;
+};
+
+
+#endif  /* SLSPATIALGRID_H */
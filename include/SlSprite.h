@@ -22,7 +22,12 @@ The SlSprite has a source rectangle which defines which part of the texture is r
 
 #include "SlRenderOptions.h"
 #include "SlTexture.h"
+#include "SlSymbolTable.h"
 
+class SlRenderBatch;
+class SlRenderState;
+class SlDirtyRegion;
+class SlSpatialGrid;
 
 
 /*! \struct SlRenderSettings
@@ -47,6 +52,9 @@ struct SlRenderSettings
   /*! Angle by which the sprite will be rotated.
    */
   double angle = 0;
+  /*! Changes whenever the destination changes (see SlSprite::markDirty()). Unique among all destinations of all sprites, so a cached rendering of the destination is valid as long as the version is the same.
+   */
+  unsigned long version = 0;
 };
 
 
@@ -83,6 +91,13 @@ class SlSprite
   /*! Adds an entry to #destinations_. The destination dimensions are set to the source dimensions, color is default.
    */
   SlSprite* addDestination(int x, int y, uint32_t renderOptions = SL_RENDER_DEFAULT);
+  /*! Adds the copy of the sprite at position i in #destinations_ to the batch instead of rendering it directly.
+    \throws std::runtime_error if invalid destination or if the batch has to be flushed and can't be rendered.
+   */
+  void addToBatch(SDL_Renderer* renderer, SlRenderBatch& batch, unsigned int i);
+  /*! Returns the area covered by destination i on screen, i.e. the destinationRect, or the box around the rotated destinationRect if the angle is not 0.
+   */
+  SDL_Rect boundingBox(unsigned int i = 0);
   /*! Centers the destination of this sprite in the destinationRect of the other sprite.
    */
   SlSprite* centerInSprite(const std::shared_ptr<SlSprite> otherSprite, unsigned int destinationThis = 0, unsigned int destinationOther = 0);
@@ -107,19 +122,43 @@ class SlSprite
   /*! Checks whether the given coordinates are inside the specified destination for this sprite.
    */
   bool is_inside(const int& x, const int& y, const unsigned int& dest = 0);
+  /*! Adds the boundingBox() of destination i to the #dirtyRegion_ , reports it to the #spatialGrid_ , and gives it a new SlRenderSettings::version. Called by all methods that change a destination; render queue manipulations call it for the items they change.
+   */
+  void markDirty(unsigned int i = 0);
   /*! Moves the sprite by the amounts given by x and y, i.e. x and y are deltas not absolutes.
   */
   void moveDestinationOriginBy(int x, int y, unsigned int i = 0);
+  /*! Moves the source rectangle by x, y in the SDL_Texture. Used when the SlTexture is moved into an atlas page.
+   */
+  void moveSourceOriginBy(int x, int y);
+  /*! SlSymbolTable ID of the name.
+   */
+  SlSymbol id() const {return id_;}
   /*! Allows reading the name, but not changing it.
    */
-  std::string name() const {return name_;}
-  /*! Renders all copies of the sprite given in #destinations_.
+  const std::string& name() const {return name_;}
+  /*! Renders all copies of the sprite given in #destinations_. With SDL 2.0.18 or newer they are drawn as one SlRenderBatch.
+    \throws std::runtime_error if unable to render.
+   */
+  void render(SDL_Renderer* renderer, SlRenderState& state);
+  /*! Adjusts the sprite after its SlTexture was replaced and the region changed from oldRegion to newRegion, see SlTexture::replaceFromSurface().
+    A sprite that showed all of oldRegion shows all of newRegion, and its destinations that had the size of oldRegion get the size of newRegion, keeping their origin. Sprites of a part of the texture keep their #sourceRect_ , it was given in the coordinates of the new texture. All destinations are marked dirty.
    */
-  void render(SDL_Renderer* renderer);
-  /*! Renders the copy of the sprite at position i in render settings.\n
+  void resizeSource(const SDL_Rect& oldRegion, const SDL_Rect& newRegion);
+  /*! Renders the copy of the sprite at position i in render settings. Colour mod, alpha mod and blend mode are set through state.\n
     \throws std::runtime_error if invalid destination or unable to render.
    */
-  void render(SDL_Renderer* renderer, unsigned int i);
+  void render(SDL_Renderer* renderer, SlRenderState& state, unsigned int i);
+  /*! The part of the SDL_Texture that the sprite shows.
+   */
+  SDL_Rect sourceRect() const {return sourceRect_;}
+  /*! Number of destination changes of all sprites so far, i.e. the last SlRenderSettings::version handed out. If it didn't change, no destination and no render queue entry changed.
+   */
+  static unsigned long changeCount() {return versionCount_;}
+  /*! Returns the complete render settings for #destinations_ at position i.
+    \throws std::out_of_range if invalid destination.
+   */
+  const SlRenderSettings& renderSettings(unsigned int i = 0) const {return destinations_.at(i);}
 
   /*! Sets angle for position i of #destinations_.
     The angle in degrees that indicates the rotation that will be applied when that sprite destination is rendered. Rotation will be around object centre.
@@ -148,6 +187,12 @@ class SlSprite
     Sets where the sprite will be rendered.
   */
   void setDestinationOrigin(int x, int y, unsigned int i = 0);
+  /*! Sets the SlDirtyRegion that is informed about changes to #destinations_ . Done by SlSpriteManager when creating the sprite.
+   */
+  void setDirtyRegion(SlDirtyRegion* dirtyRegion) {dirtyRegion_ = dirtyRegion;}
+  /*! Sets the SlSpatialGrid that is informed about changes to #destinations_ . Done by SlSpriteManager when creating the sprite.
+   */
+  void setSpatialGrid(SlSpatialGrid* grid) {spatialGrid_ = grid;}
   /*! Sets SlRenderOptions for position i of #destinations_.
     \retval false if i > #destinations_ size.
    */
@@ -155,9 +200,12 @@ class SlSprite
   /*! Number of defined destinations. Used by the SlManager to check if requested destinations are valid.
    */
   unsigned int size() {return destinations_.size();}
+  /*! The underlying SlTexture.
+   */
+  SlTexture* texture() const {return texture_;}
   /*! Access to the name of the underlying SlTexture.
    */
-  std::string textureName() const {return texture_->name();}
+  const std::string& textureName() const {return texture_->name();}
 
   
  protected:
@@ -174,16 +222,28 @@ class SlSprite
     /*! The name of a sprite cannot be changed after it is created
    */
   std::string name_ = "unnamedSprite";
+  /*! #name_ interned in the SlSymbolTable.
+   */
+  SlSymbol id_ = SL_NO_SYMBOL;
   /*! When a texture is loaded from an image file, sourceRect is set to the width and height of the texture.
-    This is set when the sprite is created.
+    This is set when the sprite is created. The coordinates are in the SDL_Texture, i.e. include the SlTexture::region() origin if the texture is in an atlas.
   */
   SDL_Rect sourceRect_ = {0,0,0,0};
   /*! Contains the actual SDL_Texture.
    */
   SlTexture* texture_;
+  /*! Source of the SlRenderSettings::version numbers.
+   */
+  static unsigned long versionCount_;
   /*! Settings for where and how to render the sprite. Multiple copies of the sprite can be rendered with different settings.
   */
   std::vector<SlRenderSettings> destinations_;
+  /*! Collects the screen areas that need to be redrawn. Owned by SlManager.
+   */
+  SlDirtyRegion* dirtyRegion_ = nullptr;
+  /*! Told about changed destinations, see markDirty().
+   */
+  SlSpatialGrid* spatialGrid_ = nullptr;
 
 };
 
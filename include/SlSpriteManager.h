@@ -16,12 +16,16 @@
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_image.h>
 
+#include "SlSymbolTable.h"
+
 
 class SlSprite;
 class SlManager;
 class SlTexture;
 class SlValueParser;
 class SlManipulation;
+class SlConfigReader;
+class SlSceneCache;
 
 
 class SlSpriteManager 
@@ -44,7 +48,7 @@ class SlSpriteManager
     Note that if the destination dimensions are changed afterwards, the sprite will no longer be centered.
    */
   void centerSpriteInSprite(const std::string& toCenter, const std::string& target, unsigned int destinationThis = 0, unsigned int destinationOther = 0);
-  /*! Checks if a sprite of the given name already exists. Calls findSprite(const std::string& name).
+  /*! Checks if a sprite of the given name already exists. Looks the name up in #spritesById_ .
     \retval true is sprite exists.
     \retval false if no sprite of that name exists.
    */
@@ -69,21 +73,37 @@ class SlSpriteManager
   /*! Delete the sprite that are based on the named SlTexture.
    */
   void deleteSprites(const std::string& textureName);
-  /*! Returns pointer to the sprite, nullptr if not found.
+  /*! Returns pointer to the sprite. Looks up the SlSymbolTable ID of name and calls findSprite(SlSymbol).
+    \throws std::invalid_argument if not found.
    */
   std::shared_ptr<SlSprite> findSprite(const std::string& name);
+  /*! Returns pointer to the sprite with SlSprite::id() id from #spritesById_ .
+    \throws std::invalid_argument if not found.
+   */
+  std::shared_ptr<SlSprite> findSprite(SlSymbol id);
   /*! set #valParser and load manipulations.
    */
   void initialize( SlValueParser* valPars);
+  /*! Moves the source rectangles of all sprites based on texture by x, y. Called when the texture was moved into an atlas page.
+   */
+  void moveSpriteSources(SlTexture* texture, int x, int y);
   /*! Get the map of SlManipulations.
    */
   std::map<std::string, SlManipulation*> manipulations(){ return manipulations_; }
-  /*! Read sprite configurations from file
+  /*! Move the sprite based on configuration file, also used by SlManager::replayScene().\
+    Currently implemented whatToDo:\n
+    setOrigin, centerAt, centerIn, setOptions
+   */
+  void manipulateSprite(const std::string& name, unsigned int destination, const std::string& whatToDo, const std::vector<std::string>& parameters);
+  /*! Read sprite configurations from file. Adds the created sprite to scene if given, or marks scene incomplete if the sprite can't be created.
    */
-  void parseSprite(std::ifstream& input);
-  /*! Read sprite placement from file.
+  void parseSprite(SlConfigReader& input, SlSceneCache* scene = nullptr);
+  /*! Read sprite placement from file. Adds the applied manipulations to scene if given, one that fails marks scene incomplete.
    */
-  void parseSpriteManipulation(std::ifstream& input);
+  void parseSpriteManipulation(SlConfigReader& input, SlSceneCache* scene = nullptr);
+  /*! Calls SlSprite::resizeSource() for all sprites based on texture. Called when an asynchronously loaded texture replaced its placeholder.
+   */
+  void resizeSpriteSources(SlTexture* texture, const SDL_Rect& oldRegion, const SDL_Rect& newRegion);
   /*! Sets color for SlSprite name at position i of SlSprite::destinations_.
 
     Color is use when using color mod to render, and when creating a texture from a rectangle.
@@ -106,20 +126,21 @@ class SlSpriteManager
   /*!Default constructor.
    */
   SlSpriteManager();
+  /*! Adds toAdd to #sprites_ and #spritesById_ .
+   */
+  void addSprite(const std::shared_ptr<SlSprite>& toAdd);
   /*! Deletes all sprites.
    */
   void clear();
-  /*! Move the sprite based on configuration file.\
-    Currently implemented whatToDo:\n
-    setOrigin, centerAt, centerIn, setOptions
-   */
-  void manipulateSprite(const std::string& name, unsigned int destination, const std::string& whatToDo, const std::vector<std::string>& parameters);
   
  private:
   /*! Holds all SlSprites that were created using SlSpriteManager methods.
     Sprites will be deleted when the SlSpriteManager instance is deleted.
    */
   std::vector<std::shared_ptr<SlSprite>> sprites_;
+  /*! The sprites of #sprites_ indexed by SlSprite::id(), nullptr for IDs without sprite.
+   */
+  std::vector<std::shared_ptr<SlSprite>> spritesById_;
   /*! The running SlManager that called the constructor.
    */
   SlManager* mngr_ = nullptr;
@@ -0,0 +1,60 @@
+// part of SDL2lazy
+// author: Ulrike Hager
+
+/*! \file SlSymbolTable.h
+  \brief SlSymbolTable class, interns sprite, texture, and font names as small integer IDs.
+*/
+
+#ifndef SLSYMBOLTABLE_H
+#define SLSYMBOLTABLE_H
+
+#include <deque>
+#include <string>
+#include <unordered_map>
+
+
+/*! ID of an interned name. IDs start at 1 and are dense, so they can index a std::vector directly.
+ */
+typedef unsigned int SlSymbol;
+
+/*! Returned by SlSymbolTable::find() for names that were never interned.
+ */
+const SlSymbol SL_NO_SYMBOL = 0;
+
+
+/*! \class SlSymbolTable
+  Process-wide table of names. SlSprite, SlTexture, and SlFont intern their name when they are created, the managers look them up by SlSymbol.\n
+  Entries are never removed, a deleted sprite's name keeps its ID and gets it again if the name is reused.
+ */
+class SlSymbolTable
+{
+ public:
+  /*! ID of name, SL_NO_SYMBOL if name was never interned. Doesn't copy name.
+   */
+  static SlSymbol find(const std::string& name);
+  /*! ID of name, adds name to the table if it isn't there yet.
+   */
+  static SlSymbol intern(const std::string& name);
+  /*! The name with ID symbol, an empty string for SL_NO_SYMBOL or unknown IDs.
+   */
+  static const std::string& name(SlSymbol symbol);
+  /*! Largest ID handed out so far.
+   */
+  static SlSymbol size() {return names_.size() - 1;}
+
+ protected:
+  /*! All static, no instances.
+   */
+  SlSymbolTable();
+
+ private:
+  /*! Maps names to IDs.
+   */
+  static std::unordered_map<std::string, SlSymbol> ids_;
+  /*! Names by ID, entry 0 is the empty name of SL_NO_SYMBOL. A deque so references returned by name() stay valid.
+   */
+  static std::deque<std::string> names_;
+};
+
+
+#endif  /* SLSYMBOLTABLE_H */
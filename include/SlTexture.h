@@ -8,6 +8,7 @@
 #ifndef SLTEXTURE_H
 #define SLTEXTURE_H
 
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <string>
@@ -15,10 +16,13 @@
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_image.h>
 
+#include "SlSymbolTable.h"
+
 
 
 class SlSprite;
 class SlFont;
+class SlRenderState;
 
 /*! \class SlTexture
 
@@ -43,16 +47,10 @@ class SlTexture
    */
   SlTexture &operator=(const SlTexture&) = delete;
 
-  /*! alphaModIsSet stores whether SDL_SetTextureAlphaMod has been applied. 
-    If true but the RenderOptions for the next render call don't request the mod
-    anymore, the texture is reset to default.
-  */
-  bool alphaModIsSet = false;
-  /*! colorModIsSet stores whether SDL_SetTextureColorMod has been applied. 
-    If true but the RenderOptions for the next render call don't request the mod
-    anymore, the texture is reset to default.
-  */
-  bool colorModIsSet = false;
+  /*! Creates an atlas page from pixels, the decoded images of the textures that moveToAtlas() will point to, drawn with blendMode. The page is a static texture, so it keeps its pixels when the render targets are reset. The caller frees pixels.
+    \throws std::runtime_error if texture can't be created.
+   */
+  SlTexture* createAtlasPage(SDL_Renderer* renderer, SDL_Surface* pixels, SDL_BlendMode blendMode);
   /*! createFromRectangle uses SDL_FillRect to create a texture based on the given geometry and the color defined in SlTextureInfo.
     \throws std::runtime_error if texture can't be created or rectangle can't be rendered.
    */
@@ -60,7 +58,7 @@ class SlTexture
   /*! Create a new texture by rendering a sprite on this texture. Calls SlSprite::render() for the sprite.
     \throws std::runtime_error if texture can't be created or rendered.    
    */
-  SlTexture* createFromSpriteOnTexture(SDL_Renderer *renderer, SlTexture* backgroundTexture, const std::shared_ptr<SlSprite> foregroundSprite);
+  SlTexture* createFromSpriteOnTexture(SDL_Renderer *renderer, SlRenderState& state, SlTexture* backgroundTexture, const std::shared_ptr<SlSprite> foregroundSprite);
   /*! Create a new texture from the message using the specified SlFont.
     \throws std::runtime_error if surface or texture can't be created.
  */
@@ -70,18 +68,79 @@ class SlTexture
     If the sprite's SlSprite::destinations_ is empty, addDefaultDestination() is called which sets the destinationRect to equal the sourceRect.
     \throws std::runtime_error if the texture can't be created or the step size for placing the tiles it <= 0.
   */
-  SlTexture* createFromTile(SDL_Renderer *renderer, const std::shared_ptr<SlSprite> tile, int width, int height);
-  /*! Returns the dimensions of the SDL_Texture.
+  SlTexture* createFromTile(SDL_Renderer *renderer, SlRenderState& state, const std::shared_ptr<SlSprite> tile, int width, int height);
+  /*! Estimated memory used by the SDL_Texture: width x height x bytes per pixel of its format.
+    \retval 0 if the texture is evicted, not created yet, or shares an atlas page.
+   */
+  std::size_t bytes();
+  /*! Creates the transparent placeholder of placeholderRegion() size that stands in for an image file until it is decoded and replaceFromSurface() swaps in the real texture.
+    \throws std::runtime_error if the texture can't be created.
+   */
+  SlTexture* createPlaceholder(SDL_Renderer* renderer);
+  /*! Returns the dimensions of the texture, i.e. of the region() in the SDL_Texture.
    */
   void dimensions(int& width, int& height);
-  /*! uses IMG_LoadTexture to get texture from png image file
+  /*! Destroys the SDL_Texture of a texture loaded from file() to free its memory, after removing it from state. region() and dimensions() keep working, reload() creates the texture again.
+    \throws std::runtime_error if the texture isn't loaded from a file or is in an atlas.
+   */
+  void evict(SlRenderState& state);
+  /*! The image file the texture was loaded from, empty if it wasn't created by loadFromFile().
+   */
+  std::string file() const {return file_;}
+  /*! Returns true if surface has no alpha channel or colour key, or all its pixels have alpha 255. Doesn't use the renderer, SlImageLoader calls it on its worker threads.
+   */
+  static bool hasOnlyOpaquePixels(SDL_Surface* surface);
+  /*! True if every pixel of the texture has alpha 255, so that it hides whatever is below it unless drawn with alpha mod.
+    Determined when the texture is created: image files are scanned at load time, rectangles are opaque if their alpha is 0xFF, textures from text are never opaque.
+   */
+  bool isOpaque() const {return isOpaque_;}
+  /*! True after evict() until reload().
+   */
+  bool isEvicted() const {return isEvicted_;}
+  /*! Frame number of the last use, set by SlTextureManager::touchTexture().
+   */
+  unsigned long lastUsed() const {return lastUsed_;}
+  /*! uses IMG_Load to get texture from png image file
     \throws std::runtime_error if object already has a texture or texture can't be loaded.    
    */
   SlTexture* loadFromFile(SDL_Renderer* renderer, const std::string& fileName);
+  /*! Creates the texture from surface, which was decoded from fileName (see SlImageLoader), and frees the surface. isOpaque is hasOnlyOpaquePixels() of the surface.
+    \throws std::runtime_error if object already has a texture or texture can't be created.
+   */
+  SlTexture* loadFromSurface(SDL_Renderer* renderer, SDL_Surface* surface, bool isOpaque, const std::string& fileName);
+  /*! Destroys the own SDL_Texture, after removing it from state, and from then on uses the page's SDL_Texture with region() at x, y. The page has to hold a copy of the image there, see createAtlasPage().
+    The SlSprite::sourceRect_ of existing sprites has to be moved by the new region() origin, sprites created afterwards are placed in the region automatically.
+    \throws std::runtime_error if the texture is already in an atlas.
+   */
+  void moveToAtlas(SlRenderState& state, SlTexture* page, int x, int y);
+  /*! False if texture() belongs to an atlas page and is shared with other SlTextures.
+   */
+  bool ownsTexture() const {return ownsTexture_;}
+  /*! The region() of a texture made by createPlaceholder().
+   */
+  static SDL_Rect placeholderRegion() {return {0,0,1,1};}
+  /*! The part of texture() that holds this texture's image. The whole SDL_Texture unless the texture was moved into an atlas.
+   */
+  SDL_Rect region();
+  /*! Loads file() again after evict(), does nothing if the texture isn't evicted.
+    \throws std::runtime_error if the image can't be loaded, the texture stays evicted.
+   */
+  SlTexture* reload(SDL_Renderer* renderer);
+  /*! Like loadFromSurface(), but replaces the existing texture, e.g. the one from createPlaceholder(). The old SDL_Texture is removed from state and destroyed once the new one exists, region() then has the dimensions of surface.
+    The SlSprite::sourceRect_ of existing sprites still refers to the old texture and has to be adjusted with SlSprite::resizeSource().
+    \throws std::runtime_error if the texture is in an atlas or can't be created, the old texture is kept in that case.
+   */
+  SlTexture* replaceFromSurface(SDL_Renderer* renderer, SlRenderState& state, SDL_Surface* surface, bool isOpaque, const std::string& fileName);
   /*! Returns the name of the texture.
     Changing the name after creation is not allowed.
    */
-  std::string name() const {return name_;}
+  const std::string& name() const {return name_;}
+  /*! Sets lastUsed().
+   */
+  void setLastUsed(unsigned long frame){ lastUsed_ = frame; }
+  /*! SlSymbolTable ID of the name.
+   */
+  SlSymbol id() const {return id_;}
   /*! Returns the SDL_texture. Changing the texture is not allowed.
    */
   SDL_Texture* texture() {return texture_;}
@@ -91,9 +150,30 @@ class SlTexture
   /*! The object's name. Cannot be changed.
    */
   std::string name_ = "unnamedTexture";
+  /*! #name_ interned in the SlSymbolTable.
+   */
+  SlSymbol id_ = SL_NO_SYMBOL;
   /*! The actual SDL_Texture.
    */
   SDL_Texture *texture_;
+  /*! False if #texture_ is an atlas page owned by another SlTexture, in that case it is not destroyed with this object.
+   */
+  bool ownsTexture_ = true;
+  /*! Position and size in the atlas page if not #ownsTexture_ , size of the texture if #isEvicted_ .
+   */
+  SDL_Rect region_ = {0,0,0,0};
+  /*! Image file for textures created by loadFromFile().
+   */
+  std::string file_;
+  /*! See isOpaque().
+   */
+  bool isOpaque_ = false;
+  /*! See isEvicted().
+   */
+  bool isEvicted_ = false;
+  /*! See lastUsed().
+   */
+  unsigned long lastUsed_ = 0;
 };
 
 #endif // SLTEXTURE_H
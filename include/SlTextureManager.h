@@ -10,12 +10,18 @@
 
 #include <memory>
 #include <string>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_image.h>
 #include <SDL2/SDL_ttf.h>
 
+#include "SlSymbolTable.h"
+#include "SlImageLoader.h"
+#include "SlTextureStats.h"
+
 
 
 class SlManager;
@@ -23,6 +29,8 @@ class SlSprite;
 class SlTexture;
 class SlValueParser;
 class SlFont;
+class SlConfigReader;
+class SlSceneCache;
 
 
 class SlTextureManager
@@ -41,7 +49,14 @@ class SlTextureManager
    */
   SlTextureManager& operator=(const SlTextureManager&) = delete;
 
-  /*! Load texture from image filename
+  /*! Loads the font filename at size and adds it to #fonts_ . color is the SlFont::color used for text textures.
+    \throws std::runtime_error if the font can't be loaded.
+   */
+  std::shared_ptr<SlFont> createFont(const std::string& name, const std::string& filename, int size, const short color[4]);
+  /*! Creates the texture with a SlTexture::createPlaceholder() and queues filename on #imageLoader_ . streamTextures() swaps in the image once it is decoded.
+   */
+  SlTexture* createTextureAsync(const std::string& name, const std::string& filename);
+  /*! Load texture from image filename. Uses the surface decoded by #imageLoader_ if filename was prefetched, and keeps it for packAtlas() if the image fits the size given to keepImagesForAtlas().
    */
   SlTexture* createTextureFromFile(const std::string& name, const std::string& filename);
   /*! Creates SlTexture using a rectangle of dimension width x height filled with the specified colour. \n
@@ -66,20 +81,79 @@ SlTexture* createTextureFromText(const std::string& name, const std::string& fon
     Also deletes the SlSprite of same name that was created automatically with the texture.
    */
   void deleteTexture(const std::string& name);
+  /*! Evicts the least recently used textures loaded from image files until the resident textures fit into the budget (see setTextureBudget()). Textures used in the current frame, textures in atlas pages and textures still streaming are never evicted. Updates SlTextureStats::residentBytes.
+    \retval Number of textures evicted.
+   */
+  unsigned int enforceBudget();
   /*! Returns pointer to the named font. 
     \retval nullptr if not found
    */
   std::shared_ptr<SlFont> findFont(const std::string& name);
+  /*! Returns pointer to the font with SlFont::id() id.
+    \retval nullptr if not found
+   */
+  std::shared_ptr<SlFont> findFont(SlSymbol id);
   /*! Returns pointer to the named texture.
     \retval nullptr if not found
    */
   SlTexture* findTexture(const std::string& name);
-  /*! Read font file, size, colour from file
+  /*! Returns pointer to the texture with SlTexture::id() id.
+    \retval nullptr if not found
+   */
+  SlTexture* findTexture(SlSymbol id);
+  /*! True while textures from createTextureAsync() are waiting for their image.
+   */
+  bool isStreaming() const {return !streaming_.empty();}
+  /*! Keeps the decoded images of the textures from createTextureFromFile() that fit on atlas pages of pageSize x pageSize until packAtlas() or releaseAtlasImages(), 0 keeps none. Set by SlManager with its atlas size.
+   */
+  void keepImagesForAtlas(int pageSize){ atlasImageSize_ = pageSize; }
+  /*! Starts a new frame for touchTexture() and enforceBudget().
+   */
+  void nextFrame(){ ++frame_; }
+  /*! Packs the textures loaded from image files that are at most half the page size into shared atlas pages of pageSize x pageSize, so that sprites from different images can be drawn without switching SDL_Textures. 
+    Uses shelf packing with 1 pixel padding between textures. Pages that would hold only one texture are not created. The page size is limited to the renderer's maximum texture size.
+    Images without alpha channel, whose textures are drawn with SDL_BLENDMODE_NONE, are packed onto their own pages, which keep that blend mode.
+    The images kept by createTextureFromFile() are copied into a surface, only files without a kept image are decoded again on the workers of #imageLoader_ . Each page is a static SDL_Texture created from the surface. Images that can't be loaded or changed size keep their own texture. Calls releaseAtlasImages() when done.
+    \retval The textures that were moved, their SlTexture::region() gives the new position.
+   */
+  std::vector<SlTexture*> packAtlas(int pageSize);
+  /*! Starts decoding filename on the worker threads of #imageLoader_ , createTextureFromFile() picks up the result. releasePrefetched() frees it if no texture took it.
+   */
+  void prefetchImage(const std::string& filename);
+  /*! Reads the texture sections of the configuration file in input and prefetches the image files of the textures of type file. Called by SlManager::parseConfigurationFile() before parsing, so the images are decoded in parallel while the file is parsed.
+   */
+  void prefetchImages(SlConfigReader& input);
+  /*! Read font file, size, colour from file. Adds the created font to scene if given, or marks scene incomplete if the font can't be created.
   */
-  std::shared_ptr<SlFont> parseFont(std::ifstream& input);
-  /*! Read texture configurations from file
+  std::shared_ptr<SlFont> parseFont(SlConfigReader& input, SlSceneCache* scene = nullptr);
+  /*! Read texture configurations from file. Adds the created texture to scene if given, or marks scene incomplete if the texture can't be created.
+    Textures of type file with "load async" are created with createTextureAsync(). Textures made from their sprites (tile, sprite-on-texture) and sprites positioned from their size (centerAt, centerIn) use the placeholder.
   */
-  SlTexture* parseTexture(std::ifstream& input);
+  SlTexture* parseTexture(SlConfigReader& input, SlSceneCache* scene = nullptr);
+  /*! Frees the images kept for packAtlas(), see keepImagesForAtlas(). Called by SlManager::render() in case the textures are never packed.
+   */
+  void releaseAtlasImages();
+  /*! Frees the images of prefetchImage() that no texture was created from, e.g. because of a duplicate name or a bad texture section. Images of textures still streaming are kept. Called by SlManager::parseConfigurationFile() when it is done.
+   */
+  void releasePrefetched();
+  /*! Replaces the placeholders of the textures from createTextureAsync() whose images are decoded with the real textures. Doesn't wait for images that are still decoding. Textures whose image can't be loaded keep the placeholder.
+    \retval The replaced textures, their SlTexture::region() was SlTexture::placeholderRegion() before.
+   */
+  std::vector<SlTexture*> streamTextures();
+  /*! Sets the memory budget for resident textures in bytes, 0 for no budget. Enforced by enforceBudget().
+   */
+  void setTextureBudget(std::size_t bytes){ budget_ = bytes; }
+  /*! The budget set with setTextureBudget().
+   */
+  std::size_t textureBudget() const {return budget_;}
+  /*! Hit, miss and eviction counters of the texture budget.
+   */
+  SlTextureStats& textureStats(){return stats_;}
+  /*! Marks texture as used in the current frame and reloads it if it was evicted. Counts a hit or miss the first time a texture is touched in a frame.
+    \retval true if the texture was reloaded, its SDL_Texture changed.
+    \throws std::runtime_error if the texture can't be reloaded.
+   */
+  bool touchTexture(SlTexture* texture);
   /*! Helper object to translate file input into values.
    */
   SlValueParser* valParser = nullptr;
@@ -101,12 +175,45 @@ SlTexture* createTextureFromText(const std::string& name, const std::string& fon
     Texture will be deleted when the SlTextureManager instance is deleted.
    */
   std::vector<SlTexture*> textures_;
+  /*! The textures of #textures_ indexed by SlTexture::id(), nullptr for IDs without texture.
+   */
+  std::vector<SlTexture*> texturesById_;
+  /*! Atlas pages created by packAtlas(). The packed SlTextures in #textures_ share the pages' SDL_Textures, so the pages are deleted last.
+   */
+  std::vector<SlTexture*> atlasPages_;
+  /*! Decodes the image files of prefetchImages() and createTextureAsync() in the background.
+   */
+  SlImageLoader imageLoader_;
+  /*! Textures from createTextureAsync() that still show the placeholder, with their image file.
+   */
+  std::vector<std::pair<SlTexture*, std::string>> streaming_;
+  /*! Files queued with prefetchImage() since the last releasePrefetched().
+   */
+  std::vector<std::string> prefetched_;
+  /*! Decoded images of textures from createTextureFromFile() for packAtlas(), see keepImagesForAtlas(). Each holds its own reference to the surface.
+   */
+  std::unordered_map<SlTexture*, SDL_Surface*> atlasImages_;
+  /*! See keepImagesForAtlas().
+   */
+  int atlasImageSize_ = 0;
+  /*! See setTextureBudget().
+   */
+  std::size_t budget_ = 0;
+  /*! Current frame number, see nextFrame(). Starts after SlTexture::lastUsed() of new textures.
+   */
+  unsigned long frame_ = 1;
+  /*! See textureStats().
+   */
+  SlTextureStats stats_;
   /*! Pointer to the running SlManager that created this TextureManager.
    */
   SlManager* mngr_ = nullptr;
   /*! Font used for rendering. This is kept open until program exits to reduce overhead from opening and closing font file.
    */
 std::vector<std::shared_ptr<SlFont>> fonts_ ;
+  /*! The fonts of #fonts_ indexed by SlFont::id().
+   */
+  std::vector<std::shared_ptr<SlFont>> fontsById_;
 
 };
 
@@ -0,0 +1,43 @@
+// part of SDL2lazy
+// author: Ulrike Hager
+
+/*! \file SlTextureStats.h
+  \brief SlTextureStats struct, counts the work of the texture memory budget.
+*/
+
+#ifndef SLTEXTURESTATS_H
+#define SLTEXTURESTATS_H
+
+#include <cstddef>
+
+
+/*! \struct SlTextureStats
+
+  Counters kept by SlTextureManager while a texture budget is set (see SlManager::setTextureBudget()). Hits, misses and evictions add up until reset(), a texture is counted at most once per frame.
+*/
+struct SlTextureStats
+{
+  /*! Textures that were resident when a render queue item used them.
+   */
+  unsigned long hits = 0;
+  /*! Evicted textures that had to be reloaded from their file because an item used them.
+   */
+  unsigned long misses = 0;
+  /*! Textures whose SDL_Texture was destroyed to stay within the budget.
+   */
+  unsigned long evictions = 0;
+  /*! Estimated bytes of the resident SDL_Textures, including atlas pages, after the last SlTextureManager::enforceBudget().
+   */
+  std::size_t residentBytes = 0;
+  /*! Sets hits, misses and evictions to 0.
+   */
+  void reset()
+  {
+    hits = 0;
+    misses = 0;
+    evictions = 0;
+  }
+};
+
+
+#endif  /* SLTEXTURESTATS_H */
@@ -8,12 +8,13 @@
 #ifndef SLVALUEPARSER_H
 #define SLVALUEPARSER_H
 
+#include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
-#include <queue>
 
+#include "SlFormula.h"
 
-class SlFormulaItem;
 
 /*! \class SlValueParser
   Translate string input from configuration files to int output.
@@ -41,10 +42,18 @@ class SlValueParser
     \throws std::runtime_error if the string can't be converted to double.
    */
   void doubleFromString(const std::string& value, double& i);
-  /*! Calculates the results of a formula (only + and - implemented).
-    \throws std::invalid_argument if the formula can't be calculated (unknown operator).
+  /*! The compiled SlFormula for formula (without quotes and whitespace). Each formula is compiled once and kept in #formulas_ , later calls return the same program.
+    \throws std::runtime_error if the formula can't be compiled.
+   */
+  std::shared_ptr<const SlFormula> compileFormula(const std::string& formula);
+  /*! Calculates the result of the formula starting at stringValues[i] (+, -, *, / and parentheses) with the compiled program from compileFormula().
+    \throws std::invalid_argument if the end of the formula can't be found, std::runtime_error if it can't be compiled.
    */
   void parseFormula(const std::vector<std::string>& stringValues, unsigned int& i, double& value);
+  /*! Copy of stringValues with each quoted formula replaced by its result, for storing parameters that don't need to be parsed again (see SlSceneCache).
+    \throws std::invalid_argument if the end of a formula can't be found, std::runtime_error if it can't be compiled.
+   */
+  std::vector<std::string> resolveFormulas(const std::vector<std::string>& stringValues);
   /*! Sets the values used for keywords SCREEN_WIDTH, SCREEN_HEIGHT.
    */
   void setDimensions(const int& width, const int& height);
@@ -78,17 +87,10 @@ class SlValueParser
     \throws std::invalid_argument if the end of the formula can't be found.
    */
   std::string assembleFormula(const std::vector<std::string>& stringValues, unsigned int& i);
-  /*! Uses the outputQueue from shuntFormula() to calculate the result of the equation.
-    \throws std::runtime_error if the items in the provided queue do not match the expected Reverse Polish notation or if an unknown operator is encountered.
-   */
-  double calculateFormula(std::queue<SlFormulaItem>& outputQueue);
-  /*! Extracts the next item from the given string, and cuts the corresponding part from the input string.
-   */
-  SlFormulaItem getNextItem(std::string& formula);
-  /*! Parses equation from assembleFormula() in infix notation and sorts it into Reverse Polish notation.
-   */
-  std::queue<SlFormulaItem> shuntFormula(std::string& formula);
 
+  /*! Compiled formulas by formula string, filled by compileFormula().
+   */
+  std::unordered_map<std::string, std::shared_ptr<const SlFormula> > formulas_;
 };
 
 /*! Include template implementation so the compiler can generate the required functions.
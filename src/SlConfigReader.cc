@@ -0,0 +1,136 @@
+// part of SDL2lazy
+// author: Ulrike Hager
+
+/*! \file SlConfigReader.cc
+
+  SlConfigReader implementation
+*/
+
+#include <charconv>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "SlConfigReader.h"
+
+
+namespace {
+  bool isSpace(char c) {return ( c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f' );}
+}
+
+
+
+SlConfigReader::SlConfigReader(const std::string& filename)
+  : filename_(filename)
+{
+#ifndef _WIN32
+  int file = open( filename.c_str(), O_RDONLY );
+  if ( file < 0 )
+    throw std::runtime_error("[SlConfigReader::SlConfigReader] Couldn't open file " + filename );
+  struct stat info = {};
+  if ( fstat(file, &info) == 0 && info.st_size > 0 ) {
+    void* mapped = mmap( nullptr, info.st_size, PROT_READ, MAP_PRIVATE, file, 0 );
+    if ( mapped != MAP_FAILED ) {
+      data_ = static_cast<const char*>(mapped);
+      size_ = info.st_size;
+      isMapped_ = true;
+    }
+  }
+  close(file);
+  if ( isMapped_ || info.st_size == 0 ) return;
+#endif
+  //! Files that can't be mapped are read into #buffer_ .
+  std::ifstream input(filename, std::ifstream::in | std::ifstream::binary);
+  if ( !input.is_open() )
+    throw std::runtime_error("[SlConfigReader::SlConfigReader] Couldn't open file " + filename );
+  buffer_.assign( std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>() );
+  data_ = buffer_.data();
+  size_ = buffer_.size();
+}
+
+
+
+SlConfigReader::~SlConfigReader()
+{
+#ifndef _WIN32
+  if ( isMapped_ ) munmap( const_cast<char*>(data_), size_ );
+#endif
+  data_ = nullptr;
+}
+
+
+
+std::string_view
+SlConfigReader::next()
+{
+  while ( cursor_ < lineEnd_ && isSpace( data_[cursor_] ) ) ++cursor_;
+  std::size_t start = cursor_;
+  while ( cursor_ < lineEnd_ && !isSpace( data_[cursor_] ) ) ++cursor_;
+  return std::string_view( data_ + start, cursor_ - start );
+}
+
+
+
+bool
+SlConfigReader::nextLine()
+{
+  if ( nextStart_ >= size_ ) {
+    lineStart_ = lineEnd_ = cursor_ = size_;
+    return false;
+  }
+  lineStart_ = cursor_ = nextStart_;
+  lineEnd_ = lineStart_;
+  while ( lineEnd_ < size_ && data_[lineEnd_] != '\n' ) ++lineEnd_;
+  nextStart_ = lineEnd_ + 1;
+  if ( lineEnd_ > lineStart_ && data_[lineEnd_-1] == '\r' ) --lineEnd_;
+  ++lineNumber_;
+  return true;
+}
+
+
+
+std::string_view
+SlConfigReader::rest()
+{
+  while ( cursor_ < lineEnd_ && isSpace( data_[cursor_] ) ) ++cursor_;
+  std::string_view result( data_ + cursor_, lineEnd_ - cursor_ );
+  cursor_ = lineEnd_;
+  return result;
+}
+
+
+
+void
+SlConfigReader::rest(std::vector<std::string>& tokens)
+{
+  for ( std::string_view token = next() ; !token.empty() ; token = next() )
+    tokens.emplace_back(token);
+}
+
+
+
+bool
+SlConfigReader::toNumber(std::string_view token, long long& value)
+{
+  const char* first = token.data();
+  if ( *first == '+' && token.size() > 1 ) ++first;
+  //! Like operator>>, a number followed by other characters converts the number.
+  return ( std::from_chars( first, token.data() + token.size(), value ).ec == std::errc() );
+}
+
+
+
+bool
+SlConfigReader::toNumber(std::string_view token, double& value)
+{
+  const char* first = token.data();
+  if ( *first == '+' && token.size() > 1 ) ++first;
+  return ( std::from_chars( first, token.data() + token.size(), value ).ec == std::errc() );
+}
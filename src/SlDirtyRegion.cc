@@ -0,0 +1,98 @@
+// part of SDL2lazy
+// author: Ulrike Hager
+
+/*! \file SlDirtyRegion.cc
+
+  SlDirtyRegion implementation
+*/
+
+#include "SlDirtyRegion.h"
+
+
+
+SlDirtyRegion::SlDirtyRegion()
+{
+}
+
+
+
+SlDirtyRegion::~SlDirtyRegion()
+{
+}
+
+
+
+void
+SlDirtyRegion::add(const SDL_Rect& rect)
+{
+  if ( isFull_ ) return;
+  rects_.push_back(rect);
+}
+
+
+
+void
+SlDirtyRegion::clear()
+{
+  rects_.clear();
+  isFull_ = false;
+}
+
+
+
+void
+SlDirtyRegion::invalidateAll()
+{
+  rects_.clear();
+  isFull_ = true;
+}
+
+
+
+const std::vector<SDL_Rect>&
+SlDirtyRegion::merge()
+{
+  if ( isFull_ ) return rects_;
+
+  std::vector<SDL_Rect> merged;
+  for ( auto& rect: rects_ ) {
+    SDL_Rect clipped;
+    if ( SDL_IntersectRect( &rect, &bounds_, &clipped ) ) merged.push_back(clipped);
+  }
+
+  //! Union overlapping rectangles until no two overlap. The unions can create new overlaps, so start over after each one.
+  bool isMerged = true;
+  while ( isMerged ) {
+    isMerged = false;
+    for ( unsigned int i = 0 ; i < merged.size() && !isMerged ; ++i ) {
+      for ( unsigned int j = i + 1 ; j < merged.size() ; ++j ) {
+	if ( SDL_HasIntersection( &merged[i], &merged[j] ) ) {
+	  SDL_UnionRect( &merged[i], &merged[j], &merged[i] );
+	  merged.erase( merged.begin() + j );
+	  isMerged = true;
+	  break;
+	}
+      }
+    }
+  }
+
+  long area = 0;
+  for ( auto& rect: merged ) area += static_cast<long>(rect.w) * rect.h;
+  if ( merged.size() > maxRects || 2 * area > static_cast<long>(bounds_.w) * bounds_.h ) {
+    invalidateAll();
+  }
+  else {
+    rects_.swap(merged);
+  }
+  return rects_;
+}
+
+
+
+void
+SlDirtyRegion::setBounds(int width, int height)
+{
+  bounds_.w = width;
+  bounds_.h = height;
+  invalidateAll();
+}
@@ -6,14 +6,16 @@
   SlEventHandler, SlEventObject, SlEventAction implementation
 */
 
-#include <sstream>
-#include <fstream>
+#include <string_view>
 #include <iostream>
 #include <stdexcept>
 #include <algorithm>
 
+#include "SlConfigReader.h"
+#include "SlSceneCache.h"
 #include "SlManipulation.h"
 #include "SlRenderItem.h"
+#include "SlFrameProfiler.h"
 
 #include "SlEventHandler.h"
 
@@ -21,11 +23,12 @@
 /*! \class SlEventAction
  */
 void
-SlEventAction::act( std::vector<std::string> additionalParams )
+SlEventAction::act(const int* mouse)
 {
-  parameters.insert( parameters.end(), additionalParams.begin(), additionalParams.end() );
+  arguments.hasMouse = ( mouse != nullptr );
+  if ( mouse ) std::copy( mouse, mouse + 4, arguments.mouse );
   try {
-    manipulation->manipulate( name, destination, parameters );
+    manipulation->apply( name, destination, arguments );
   }
   catch (const std::exception& expt) {
     std::cerr << expt.what() << std::endl;
@@ -56,7 +59,7 @@ SlEventObject::~SlEventObject()
 
 
 void
-SlEventObject::addAction(std::string name, int destination, SlManipulation* manip, std::vector<std::string> params )
+SlEventObject::addAction(const std::string& name, int destination, SlManipulation* manip, const std::vector<std::string>& params )
 {
 #ifdef DEBUG
   std::cout << "[SlEventObject::addAction] added manipulation " << manip->name() << " for sprite " << name << std::endl;
@@ -65,7 +68,8 @@ SlEventObject::addAction(std::string name, int destination, SlManipulation* mani
   toAdd.name = name;
   toAdd.destination = destination;
   toAdd.manipulation = manip;
-  toAdd.parameters = params;
+  toAdd.arguments.parameters = params;
+  manip->prepareArguments( toAdd.arguments );
   actions_.push_back( toAdd );
 }
 
@@ -75,17 +79,13 @@ SlEventObject::addAction(std::string name, int destination, SlManipulation* mani
 void
 SlEventObject::trigger(int mouse_x, int mouse_y)
 {
-  std::vector<std::string> additionalParams;
+  int mouse[4] = { mouse_x, mouse_y, mouse_x - last_mouse_[0], mouse_y - last_mouse_[1] };
   if ( need_mouse_coordinates ) {
-    additionalParams.push_back( std::to_string( mouse_x ) );
-    additionalParams.push_back( std::to_string( mouse_y) );
-    additionalParams.push_back( std::to_string( mouse_x-last_mouse_[0] ) );
-    additionalParams.push_back( std::to_string( mouse_y-last_mouse_[1] ) );
     last_mouse_[0] = mouse_x;
     last_mouse_[1] = mouse_y;
   }
-  for (auto action: actions_) {
-    action.act(additionalParams);
+  for (auto& action: actions_) {
+    action.act( need_mouse_coordinates ? mouse : nullptr );
   }
 }
 
@@ -94,7 +94,9 @@ SlEventObject::trigger(int mouse_x, int mouse_y)
 /*! \class SlEventHandler
  */
 SlEventHandler::SlEventHandler()
+  : keyActions_(SDL_NUM_SCANCODES)
 {
+  wakeUpEvent_ = SDL_RegisterEvents(1);
 }
 
 
@@ -109,29 +111,66 @@ void
 SlEventHandler::addAction(const std::string& key, const std::string& whatToDo, const std::string& spritename, int destination, std::vector<std::string> parameters )
 {
   if ( key == "leftclick" && whatToDo == "move") {
-    SlEventObject& obj1 = eventActions_["is_mouse-down"];
+    SlEventObject& obj1 = eventObject("mouse-down");
     obj1.need_mouse_coordinates = true;
     SlManipulation* manip = getManipulation( "activateIfInside" );
     obj1.addAction( spritename, destination, manip, parameters );
 
-    SlEventObject& obj2 = eventActions_["is_mouse-move"];
+    SlEventObject& obj2 = eventObject("mouse-move");
     obj2.need_mouse_coordinates = true;
     manip = getManipulation( "moveActiveBy" );
     obj2.addAction( spritename, destination, manip, parameters );
 
-    SlEventObject& obj3 = eventActions_["is_mouse-up"];
+    SlEventObject& obj3 = eventObject("mouse-up");
     manip = getManipulation( "deactivate" );
     obj3.addAction( spritename, destination, manip, parameters );
   }
+  else if ( key == "leftclick" && whatToDo == "pick") {
+    SlEventObject& obj1 = eventObject("mouse-down");
+    obj1.need_mouse_coordinates = true;
+    obj1.addAction( spritename, destination, getManipulation( "pick" ), parameters );
+
+    SlEventObject& obj2 = eventObject("mouse-move");
+    obj2.need_mouse_coordinates = true;
+    obj2.addAction( spritename, destination, getManipulation( "movePickedBy" ), parameters );
+
+    SlEventObject& obj3 = eventObject("mouse-up");
+    obj3.addAction( spritename, destination, getManipulation( "drop" ), parameters );
+  }
   else {
     SlManipulation* manip = getManipulation( whatToDo );
-    std::string keyword = "is_" + key;
-    SlEventObject& obj = eventActions_[keyword];
+    SlEventObject& obj = eventObject(key);
     obj.addAction(spritename, destination, manip, parameters);
   }
 }
 
 
+
+SlEventObject&
+SlEventHandler::eventObject(const std::string& key)
+{
+  std::unique_ptr<SlEventObject>* slot = nullptr;
+  if ( key == "mouse-down" ) 
+    slot = &mouseActions_[SL_MOUSE_DOWN];
+  else if ( key == "mouse-up" ) 
+    slot = &mouseActions_[SL_MOUSE_UP];
+  else if ( key == "mouse-move" ) 
+    slot = &mouseActions_[SL_MOUSE_MOVE];
+  else {
+    //! Key names are resolved with the current keyboard layout, so "m" is bound to whichever key types an m.
+    SDL_Scancode code = SDL_SCANCODE_UNKNOWN;
+    SDL_Keycode sym = SDL_GetKeyFromName( key.c_str() );
+    if ( sym != SDLK_UNKNOWN ) code = SDL_GetScancodeFromKey(sym);
+    if ( code == SDL_SCANCODE_UNKNOWN ) code = SDL_GetScancodeFromName( key.c_str() );
+    if ( code == SDL_SCANCODE_UNKNOWN || code >= static_cast<int>( keyActions_.size() ) )
+      throw std::invalid_argument( "[SlEventHandler::eventObject] Error: unknown key " + key );
+    slot = &keyActions_[code];
+  }
+  if ( !(*slot) ) slot->reset( new SlEventObject );
+  return **slot;
+}
+
+
 void
 SlEventHandler::addManipulations(const std::map<std::string, SlManipulation*>& manip)
 {
@@ -155,73 +194,52 @@ SlEventHandler::getManipulation(const std::string& whatToDo)
 int
 SlEventHandler::handleEvent(const SDL_Event& event)
 {
-  std::string keyword = "";
+  SlEventObject* obj = nullptr;
   int mouse_x = -1, mouse_y = -1;
 
   if (event.type == SDL_QUIT) return 1;
+  else if (event.type == SDL_WINDOWEVENT) {
+    switch (event.window.event) {
+    case SDL_WINDOWEVENT_SHOWN: case SDL_WINDOWEVENT_EXPOSED: case SDL_WINDOWEVENT_SIZE_CHANGED:
+      redrawRequested = true;
+      break;
+    }
+    return 0;
+  }
+  else if (event.type == SDL_RENDER_TARGETS_RESET || event.type == SDL_RENDER_DEVICE_RESET) {
+    targetsReset = true;
+    redrawRequested = true;
+    return 0;
+  }
+  else if (event.type == wakeUpEvent_) {
+    redrawRequested = true;
+    return 0;
+  }
   else if (event.type == SDL_MOUSEBUTTONDOWN)
     {
       SDL_GetMouseState( &mouse_x, &mouse_y );
-      keyword = "is_mouse-down";
+      obj = mouseActions_[SL_MOUSE_DOWN].get();
     }
   else if (event.type == SDL_MOUSEBUTTONUP) {
       SDL_GetMouseState( &mouse_x, &mouse_y );
-      keyword = "is_mouse-up";
+      obj = mouseActions_[SL_MOUSE_UP].get();
   }
   else if (event.type == SDL_MOUSEMOTION) {
-    //    int relx, rely;
     SDL_GetMouseState( &mouse_x, &mouse_y );
-    //   SDL_GetRelativeMouseState(&relx, &rely);
-    keyword = "is_mouse-move";
+    obj = mouseActions_[SL_MOUSE_MOVE].get();
   }
   else if (event.type == SDL_KEYDOWN)
     {
-      switch(event.key.keysym.sym)
-	{
-	case SDLK_UP:
-	  keyword = "is_up";
-	  break;
-	case SDLK_DOWN:
-	  keyword = "is_down";
-	  break;
-	case SDLK_LEFT:
-	  keyword = "is_left";
-	  break;
-	case SDLK_RIGHT:
-	  keyword = "is_right";
-	  break;
-	case SDLK_1:
-	  keyword = "is_1";
-	  break;
-	case SDLK_2:
-	  keyword = "is_2";
-	  break;
-	case SDLK_3:
-	  keyword = "is_3";
-	  break;
-	case SDLK_4:
-	  keyword = "is_4";
-	  break;
-	case SDLK_m:
-	  keyword = "is_m";
-	  break;
-	case SDLK_n:
-	  keyword = "is_n";
-	  break;
-	case SDLK_b:
-	  keyword = "is_b";
-	  break;
-	case SDLK_f:
-	  keyword = "is_f";
-	  break;
-	case SDLK_ESCAPE:
-	  return 1;
-	}
+      SDL_Scancode code = event.key.keysym.scancode;
+      if ( code < static_cast<int>( keyActions_.size() ) ) obj = keyActions_[code].get();
+      if ( obj == nullptr && code == SDL_SCANCODE_ESCAPE ) return 1;
     }
 
-  auto iter = eventActions_.find( keyword );
-  if ( iter != eventActions_.end() )   //!< undefined input is ignored.
-    iter->second.trigger(mouse_x, mouse_y);
+  if ( obj ) {   //!< undefined input is ignored.
+    if ( profiler_ ) profiler_->begin(SL_PHASE_DISPATCH);
+    obj->trigger(mouse_x, mouse_y);
+    if ( profiler_ ) profiler_->end(SL_PHASE_DISPATCH);
+  }
   
   return 0;
 }
@@ -229,19 +247,16 @@ SlEventHandler::handleEvent(const SDL_Event& event)
 
 
 void
-SlEventHandler::parseEvent(std::ifstream& input)
+SlEventHandler::parseEvent(SlConfigReader& input, SlSceneCache* scene)
 {
-  std::string line, token;
   std::string key, whatToDo, spritename;
-  int destination ;
+  int destination = 0;
   std::vector<std::string> parameters;
   bool endOfConfig = false;
   
-  getline(input,line);
-  while ( !endOfConfig && input ) {
-    std::istringstream stream(line.c_str());
-    stream >> token;
-    if ( token[0] == '#' || token.empty() || token[0] == '\n'  ) {
+  while ( !endOfConfig && input.nextLine() ) {
+    std::string_view token = input.next();
+    if ( token.empty() || token[0] == '#' ) {
       /* empty line or comment */
     }
     else if ( token == "end" ) {
@@ -250,35 +265,100 @@ SlEventHandler::parseEvent(std::ifstream& input)
     else {
       try {
 	key = token;
-	stream >> whatToDo;
-	stream >> spritename;
-	stream >> destination;
-	while ( !stream.eof() ){
-	  parameters.push_back("");
-	  stream >> parameters.back();
-	}
-	if ( !parameters.empty() && parameters.back().empty() )
-	  parameters.pop_back();
+	whatToDo = input.next();
+	spritename = input.next();
+	input.next(destination);
+	input.rest(parameters);
 	addAction(key, whatToDo, spritename, destination, parameters);
+	if ( scene )
+	  scene->add( SL_SCENE_EVENT, {key, whatToDo, spritename}, {destination}, parameters );
       }
       catch (const std::exception& expt ) {
-	std::cerr << "[SlEventHandler::parseEvent] Error: " << expt.what() << std::endl;
+	std::cerr << "[SlEventHandler::parseEvent] Error in " << input.filename() << ":" << input.lineNumber() << ": " << expt.what() << std::endl;
+	if ( scene ) scene->markIncomplete();
       }
     }
-    token.clear();
+    destination = 0;
     parameters.clear();
-    if ( !endOfConfig ) getline(input,line);
   }
 }
 
 
 
+void
+SlEventHandler::collectMotion(const SDL_Event& event)
+{
+  if ( !hasMotion_ ) {
+    motion_ = event;
+    hasMotion_ = true;
+    return;
+  }
+  int xrel = motion_.motion.xrel + event.motion.xrel;
+  int yrel = motion_.motion.yrel + event.motion.yrel;
+  motion_ = event;
+  motion_.motion.xrel = xrel;
+  motion_.motion.yrel = yrel;
+}
+
+
+
+int
+SlEventHandler::flushMotion()
+{
+  if ( !hasMotion_ ) return 0;
+  hasMotion_ = false;
+  return handleEvent(motion_);
+}
+
+
+
 int
 SlEventHandler::pollEvent()
 {
   int result = 0;  //!< 0 means don't quit, 1 means quit
+  if ( profiler_ ) profiler_->begin(SL_PHASE_EVENTS);
   while (SDL_PollEvent(&event_)) {
-    result = handleEvent(event_);
+    if ( coalesceMotion_ && event_.type == SDL_MOUSEMOTION ) {
+      collectMotion(event_);
+      continue;
+    }
+    if ( event_.type == SDL_MOUSEBUTTONDOWN || event_.type == SDL_MOUSEBUTTONUP ) {
+      if ( flushMotion() ) result = 1;
+    }
+    if ( handleEvent(event_) ) result = 1;
   }
+  if ( flushMotion() ) result = 1;
+  if ( profiler_ ) profiler_->end(SL_PHASE_EVENTS);
   return result;
 }
+
+
+
+int
+SlEventHandler::waitEvent(int timeout)
+{
+  int result = 0;
+  if ( SDL_WaitEventTimeout(&event_, timeout) ) {
+    //! pollEvent() times itself, only the first event has to be added.
+    if ( profiler_ ) profiler_->begin(SL_PHASE_EVENTS);
+    if ( coalesceMotion_ && event_.type == SDL_MOUSEMOTION ) 
+      collectMotion(event_);   //!< handled with the rest of the motion by pollEvent()
+    else
+      result = handleEvent(event_);
+    if ( profiler_ ) profiler_->end(SL_PHASE_EVENTS);
+    if ( pollEvent() ) result = 1;
+  }
+  return result;
+}
+
+
+
+void
+SlEventHandler::wakeUp()
+{
+  if ( wakeUpEvent_ == static_cast<uint32_t>(-1) ) return;
+  SDL_Event event;
+  SDL_memset( &event, 0, sizeof(event) );
+  event.type = wakeUpEvent_;
+  SDL_PushEvent( &event );
+}
@@ -14,6 +14,7 @@
 
 SlFont::SlFont(std::string name)
   : name_(name)
+  , id_( SlSymbolTable::intern(name) )
 {
   font_ = nullptr;
 }
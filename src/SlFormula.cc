@@ -0,0 +1,192 @@
+// part of SDL2lazy
+// author: Ulrike Hager
+
+/*! \file SlFormula.cc
+
+  SlFormula implementation
+*/
+
+#include <algorithm>
+#include <sstream>
+#include <stack>
+#include <stdexcept>
+
+#include "SlFormulaItem.h"
+#include "SlFormula.h"
+
+
+
+SlFormula::SlFormula(const std::string& formula)
+{
+  compile(formula);
+}
+
+
+
+double
+SlFormula::apply(char what, double lhs, double rhs)
+{
+  switch ( what ) {
+  case '+':
+    return lhs + rhs;
+  case '-':
+    return lhs - rhs;
+  case '*':
+    return lhs * rhs;
+  default:
+    return lhs / rhs;
+  }
+}
+
+
+
+void
+SlFormula::compile(const std::string& formula)
+{
+  program_.clear();
+  depth_ = 0;
+  std::stack<SlFormulaItem> operatorStack;
+  unsigned int stackSize = 0;         //!< Values on the stack when running the program so far.
+  double sign = 1;                    //!< Leading unary - applies to the first value.
+
+  auto emitOperator = [&](char what) {
+    if ( stackSize < 2 )              //!< need two numbers to use operator
+      throw std::runtime_error("Bad formula: " + formula);
+    --stackSize;
+    emit(what);
+  };
+
+  std::string::size_type pos = 0;
+  while ( pos < formula.size() ) {
+    std::string::size_type end = pos + 1;
+    if ( std::string("+-*/()").find( formula[pos] ) == std::string::npos ) {
+      end = formula.find_first_of("+-*/()", pos);
+      if ( end == std::string::npos ) end = formula.size();
+    }
+    if ( end - pos == 1 && !isdigit( formula[pos] ) ) {
+      SlFormulaItem currentItem( formula[pos] );
+      switch ( currentItem.what ) {
+      case '+': case '-': case '*': case '/':
+	if ( program_.empty() ) {              //!< Leading unary - (or plus)
+	  if ( currentItem.what == '-' ) sign = -1;
+	  break;
+	}
+	while ( !operatorStack.empty() && operatorStack.top().precedence >= currentItem.precedence ) {
+	  emitOperator( operatorStack.top().what );
+	  operatorStack.pop();
+	}
+	operatorStack.push(currentItem);
+	break;
+      case '(':
+	operatorStack.push(currentItem);
+	break;
+      case ')':
+	while ( !operatorStack.empty() && operatorStack.top().what != '(' ) {
+	  emitOperator( operatorStack.top().what );
+	  operatorStack.pop();
+	}
+	if ( operatorStack.empty() )
+	  throw std::runtime_error("Unmatched ')' in formula: " + formula);
+	operatorStack.pop();
+	break;
+      }
+    }
+    else {
+      Instruction value = {'n', sign};
+      std::string token = formula.substr(pos, end - pos);
+      if ( token == "SCREEN_WIDTH" )
+	value.what = 'w';
+      else if ( token == "SCREEN_HEIGHT" )
+	value.what = 'h';
+      else {
+	std::istringstream is(token);
+	double number;
+	if ( !(is >> number) )
+	  throw std::runtime_error("Invalid conversion to double of string: \"" + token + "\"");
+	value.value *= number;
+      }
+      sign = 1;
+      program_.push_back(value);
+      depth_ = std::max( depth_, ++stackSize );
+    }
+    pos = end;
+  }
+
+  while ( !operatorStack.empty() ) {
+    if ( operatorStack.top().what == '(' )
+      throw std::runtime_error("Unmatched '(' in formula: " + formula);
+    emitOperator( operatorStack.top().what );
+    operatorStack.pop();
+  }
+  if ( stackSize != 1 )
+    throw std::runtime_error("Bad formula: " + formula);
+}
+
+
+
+void
+SlFormula::emit(char what)
+{
+  std::size_t size = program_.size();
+  if ( size >= 2 ) {
+    Instruction& lhs = program_[size-2];
+    const Instruction& rhs = program_[size-1];
+    if ( lhs.what == 'n' && rhs.what == 'n' ) {
+      lhs.value = apply(what, lhs.value, rhs.value);
+      program_.pop_back();
+      return;
+    }
+    //! SCREEN_WIDTH and SCREEN_HEIGHT are stored with a factor, scaling them by a constant only changes the factor.
+    bool lhsIsVariable = ( lhs.what == 'w' || lhs.what == 'h' );
+    bool rhsIsVariable = ( rhs.what == 'w' || rhs.what == 'h' );
+    if ( lhsIsVariable && rhs.what == 'n' && ( what == '*' || what == '/' ) ) {
+      lhs.value = apply(what, lhs.value, rhs.value);
+      program_.pop_back();
+      return;
+    }
+    if ( lhs.what == 'n' && rhsIsVariable && what == '*' ) {
+      Instruction variable = {rhs.what, lhs.value * rhs.value};
+      lhs = variable;
+      program_.pop_back();
+      return;
+    }
+  }
+  Instruction instruction = {what, 0};
+  program_.push_back(instruction);
+}
+
+
+
+double
+SlFormula::evaluate(double width, double height) const
+{
+  if ( program_.empty() ) return 0;
+  //! Formulas from configuration files are short, larger stacks are allocated.
+  double local[16];
+  std::vector<double> allocated;
+  double* stack = local;
+  if ( depth_ > 16 ) {
+    allocated.resize(depth_);
+    stack = allocated.data();
+  }
+
+  unsigned int top = 0;
+  for ( const auto& instruction: program_ ) {
+    switch ( instruction.what ) {
+    case 'n':
+      stack[top++] = instruction.value;
+      break;
+    case 'w':
+      stack[top++] = instruction.value * width;
+      break;
+    case 'h':
+      stack[top++] = instruction.value * height;
+      break;
+    default:
+      --top;
+      stack[top-1] = apply( instruction.what, stack[top-1], stack[top] );
+      break;
+    }
+  }
+  return stack[0];
+}
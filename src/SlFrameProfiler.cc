@@ -0,0 +1,157 @@
+// part of SDL2lazy
+// author: Ulrike Hager
+
+/*! \file SlFrameProfiler.cc
+
+  SlFrameProfiler implementation
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+#include <SDL2/SDL.h>
+
+#include "SlFrameProfiler.h"
+
+
+
+SlFrameProfiler::SlFrameProfiler()
+{
+}
+
+
+
+SlFrameProfiler::~SlFrameProfiler()
+{
+}
+
+
+
+void
+SlFrameProfiler::begin(SlFramePhase phase)
+{
+  if ( frames_.empty() ) return;
+  started_[phase] = SDL_GetPerformanceCounter();
+}
+
+
+
+void
+SlFrameProfiler::beginFrame()
+{
+  if ( frames_.empty() ) return;
+  if ( stored_ > 0 ) current_ = ( current_ + 1 ) % frames_.size();
+  stored_ = std::min<unsigned int>( stored_ + 1, frames_.size() );
+  std::fill( frames_[current_].begin(), frames_[current_].end(), 0 );
+  frameStarted_ = SDL_GetPerformanceCounter();
+}
+
+
+
+void
+SlFrameProfiler::end(SlFramePhase phase)
+{
+  if ( frames_.empty() || stored_ == 0 ) return;
+  frames_[current_][phase] += SDL_GetPerformanceCounter() - started_[phase];
+}
+
+
+
+void
+SlFrameProfiler::endFrame()
+{
+  if ( frames_.empty() || stored_ == 0 ) return;
+  frames_[current_][SL_PHASE_FRAME] = SDL_GetPerformanceCounter() - frameStarted_;
+}
+
+
+
+double
+SlFrameProfiler::microseconds(uint64_t ticks) const
+{
+  return 1.0e6 * ticks / frequency_;
+}
+
+
+
+std::string
+SlFrameProfiler::phaseName(SlFramePhase phase)
+{
+  switch (phase) {
+  case SL_PHASE_EVENTS:
+    return "events";
+  case SL_PHASE_DISPATCH:
+    return "dispatch";
+  case SL_PHASE_UPDATE:
+    return "update";
+  case SL_PHASE_RENDER:
+    return "render";
+  case SL_PHASE_PRESENT:
+    return "present";
+  case SL_PHASE_FRAME:
+    return "frame";
+  default:
+    return "unknown";
+  }
+}
+
+
+
+void
+SlFrameProfiler::setCapacity(unsigned int frames)
+{
+  frames_.assign( frames, std::vector<uint64_t>( SL_PHASE_COUNT, 0 ) );
+  current_ = 0;
+  stored_ = 0;
+  frequency_ = SDL_GetPerformanceFrequency();
+}
+
+
+
+SlPhaseStats
+SlFrameProfiler::stats(SlFramePhase phase) const
+{
+  SlPhaseStats result;
+  if ( stored_ == 0 ) return result;
+
+  std::vector<uint64_t> values;
+  values.reserve(stored_);
+  for ( unsigned int i = 0 ; i < stored_ ; ++i ) values.push_back( frames_[i][phase] );
+  std::sort( values.begin(), values.end() );
+
+  //! Nearest-rank percentiles.
+  auto percentile = [&values](double p) -> uint64_t {
+    unsigned int rank = static_cast<unsigned int>( std::ceil( p / 100.0 * values.size() ) );
+    return values.at( std::max( rank, 1u ) - 1 );
+  };
+  result.p50 = microseconds( percentile(50) );
+  result.p95 = microseconds( percentile(95) );
+  result.p99 = microseconds( percentile(99) );
+  result.max = microseconds( values.back() );
+  return result;
+}
+
+
+
+bool
+SlFrameProfiler::writeCsv(const std::string& filename) const
+{
+  std::ofstream output(filename, std::ofstream::out);
+  if ( !output.is_open() ) return false;
+
+  output << "frame";
+  for ( int phase = 0 ; phase < SL_PHASE_COUNT ; ++phase )
+    output << "," << phaseName( static_cast<SlFramePhase>(phase) ) << "_us";
+  output << "\n";
+
+  unsigned int oldest = ( stored_ < frames_.size() ? 0 : ( current_ + 1 ) % frames_.size() );
+  for ( unsigned int i = 0 ; i < stored_ ; ++i ) {
+    const std::vector<uint64_t>& frame = frames_[ ( oldest + i ) % frames_.size() ];
+    output << i;
+    for ( int phase = 0 ; phase < SL_PHASE_COUNT ; ++phase )
+      output << "," << microseconds( frame[phase] );
+    output << "\n";
+  }
+  return output.good();
+}
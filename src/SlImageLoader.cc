@@ -0,0 +1,145 @@
+// part of SDL2lazy
+// author: Ulrike Hager
+
+/*! \file SlImageLoader.cc
+
+  SlImageLoader implementation
+*/
+
+#include <algorithm>
+#include <stdexcept>
+
+#include <SDL2/SDL_image.h>
+
+#include "SlTexture.h"
+#include "SlImageLoader.h"
+
+
+
+SlImageLoader::SlImageLoader(unsigned int threads)
+  : threadCount_(threads)
+{
+  if ( threadCount_ == 0 ) threadCount_ = std::max( 1u, std::thread::hardware_concurrency() );
+}
+
+
+
+SlImageLoader::~SlImageLoader()
+{
+  clear();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    isStopping_ = true;
+  }
+  queued_.notify_all();
+  for ( auto& worker: workers_ ) worker.join();
+}
+
+
+
+void
+SlImageLoader::clear()
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  queue_.clear();
+  decoded_.wait( lock, [this]{ return busy_ == 0; } );
+  for ( auto& entry: images_ ) {
+    if ( entry.second.surface ) SDL_FreeSurface( entry.second.surface );
+  }
+  images_.clear();
+}
+
+
+
+void
+SlImageLoader::drop(const std::string& filename)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto iter = images_.find(filename);
+  if ( iter == images_.end() ) return;
+  if ( iter->second.surface ) SDL_FreeSurface( iter->second.surface );
+  images_.erase(iter);
+  auto queued = std::find( queue_.begin(), queue_.end(), filename );
+  if ( queued != queue_.end() ) queue_.erase(queued);
+}
+
+
+
+bool
+SlImageLoader::isReady(const std::string& filename)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto iter = images_.find(filename);
+  return ( iter == images_.end() || iter->second.isDone );
+}
+
+
+
+void
+SlImageLoader::prefetch(const std::string& filename)
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if ( !images_.emplace( filename, Image() ).second ) return;
+    queue_.push_back(filename);
+    //! One more worker per queued file, up to #threadCount_ .
+    if ( workers_.size() < threadCount_ && workers_.size() < queue_.size() + busy_ )
+      workers_.emplace_back( &SlImageLoader::work, this );
+  }
+  queued_.notify_one();
+}
+
+
+
+bool
+SlImageLoader::take(const std::string& filename, SDL_Surface*& surface, bool& isOpaque)
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  auto iter = images_.find(filename);
+  if ( iter == images_.end() ) return false;
+  decoded_.wait( lock, [&iter]{ return iter->second.isDone; } );
+  Image image = iter->second;
+  images_.erase(iter);
+  lock.unlock();
+
+  if ( image.surface == nullptr )
+    throw std::runtime_error("Unable to load image " + filename + " " + image.error );
+  surface = image.surface;
+  isOpaque = image.isOpaque;
+  return true;
+}
+
+
+
+void
+SlImageLoader::work()
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  while ( true ) {
+    queued_.wait( lock, [this]{ return isStopping_ || !queue_.empty(); } );
+    if ( isStopping_ ) return;
+    std::string filename = queue_.front();
+    queue_.pop_front();
+    ++busy_;
+    lock.unlock();
+
+    SDL_Surface* surface = IMG_Load( filename.c_str() );
+    bool isOpaque = ( surface && SlTexture::hasOnlyOpaquePixels(surface) );
+    std::string error = ( surface ? "" : SDL_GetError() );
+
+    lock.lock();
+    --busy_;
+    auto iter = images_.find(filename);
+    if ( iter == images_.end() ) {
+      //! Dropped by clear() while decoding.
+      if ( surface ) SDL_FreeSurface(surface);
+    }
+    else {
+      iter->second.surface = surface;
+      iter->second.isOpaque = isOpaque;
+      iter->second.error = error;
+      iter->second.isDone = true;
+    }
+    decoded_.notify_all();
+  }
+}
@@ -0,0 +1,214 @@
+// part of SDL2lazy
+// author: Ulrike Hager
+
+/*! \file SlLayerCache.cc
+
+  SlLayerCache implementation
+*/
+
+#include <iostream>
+#include <stdexcept>
+
+#include "SlTexture.h"
+#include "SlSprite.h"
+#include "SlRenderItem.h"
+#include "SlRenderState.h"
+#include "SlLayerCache.h"
+
+
+
+SlLayerCache::SlLayerCache()
+{
+}
+
+
+
+SlLayerCache::~SlLayerCache()
+{
+}
+
+
+
+bool
+SlLayerCache::build(SDL_Renderer* renderer, SlRenderState& state, const std::vector<SlRenderItem*>& queue, unsigned int first, unsigned int last, int width, int height)
+{
+  bool isBottom = ( first == 0 );
+  if ( !isBottom && !canBlend_ ) return false;
+
+  Layer layer;
+  layer.first = first;
+  layer.texture = SDL_CreateTexture(renderer, 0, SDL_TEXTUREACCESS_TARGET, width, height);
+  if ( layer.texture == nullptr ) {
+    std::cerr << "[SlLayerCache::build] Couldn't create layer, not caching any more: " << SDL_GetError() << std::endl;
+    canCreate_ = false;
+    return false;
+  }
+
+  if ( isBottom ) {
+    SDL_SetTextureBlendMode( layer.texture, SDL_BLENDMODE_NONE );
+  }
+  else {
+    int check = -1;
+#if SL_HAVE_CUSTOM_BLEND
+    SDL_BlendMode premultiplied = SDL_ComposeCustomBlendMode( SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD,
+							      SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD );
+    check = SDL_SetTextureBlendMode( layer.texture, premultiplied );
+#endif
+    if ( check != 0 ) {
+#ifdef DEBUG
+      std::cout << "[SlLayerCache::build] Renderer doesn't support premultiplied alpha, only caching the start of the render queue." << std::endl;
+#endif
+      canBlend_ = false;
+      SDL_DestroyTexture( layer.texture );
+      return false;
+    }
+  }
+
+  SDL_SetRenderTarget( renderer, layer.texture );
+  if ( isBottom ) {
+    SDL_RenderClear( renderer );
+  }
+  else {
+    uint8_t red, green, blue, alpha;
+    SDL_GetRenderDrawColor( renderer, &red, &green, &blue, &alpha );
+    SDL_SetRenderDrawColor( renderer, 0x00, 0x00, 0x00, 0x00 );
+    SDL_RenderClear( renderer );
+    SDL_SetRenderDrawColor( renderer, red, green, blue, alpha );
+  }
+
+  SDL_Rect screen = {0, 0, width, height};
+  bool hasBounds = false;
+  for ( unsigned int i = first ; i < last ; ++i ) {
+    SlRenderItem* item = queue[i];
+    LayerItem cached = {item, 0, item->renderMe_};
+    itemVersion( item, cached.version );
+    layer.items.push_back(cached);
+    if ( !item->renderMe_ ) continue;
+    try {
+      SDL_Rect box = item->sprite_->boundingBox( item->destination_ );
+      if ( !SDL_IntersectRect( &box, &screen, &box ) ) continue;
+      if ( hasBounds )
+	SDL_UnionRect( &layer.bounds, &box, &layer.bounds );
+      else
+	layer.bounds = box;
+      hasBounds = true;
+      item->sprite_->render( renderer, state, item->destination_ );
+    }
+    catch (const std::exception& expt){
+      std::cerr << expt.what() << std::endl;
+    }
+  }
+  SDL_SetRenderTarget( renderer, nullptr );
+
+  layers_.push_back(layer);
+  return true;
+}
+
+
+
+void
+SlLayerCache::clear()
+{
+  for ( auto& layer: layers_ ) {
+    SDL_DestroyTexture( layer.texture );
+  }
+  layers_.clear();
+  layerStart_.clear();
+}
+
+
+
+bool
+SlLayerCache::isValid(const Layer& layer, const std::vector<SlRenderItem*>& queue) const
+{
+  if ( layer.first + layer.items.size() > queue.size() ) return false;
+  for ( unsigned int i = 0 ; i < layer.items.size() ; ++i ) {
+    SlRenderItem* item = queue[layer.first + i];
+    const LayerItem& cached = layer.items[i];
+    unsigned long version;
+    if ( item != cached.item || item->renderMe_ != cached.renderMe ) return false;
+    if ( !itemVersion(item, version) || version != cached.version ) return false;
+  }
+  return true;
+}
+
+
+
+bool
+SlLayerCache::itemVersion(SlRenderItem* item, unsigned long& version)
+{
+  try {
+    version = item->sprite_->renderSettings( item->destination_ ).version;
+  }
+  catch (const std::exception& expt){
+    return false;
+  }
+  return true;
+}
+
+
+
+SDL_Texture*
+SlLayerCache::layerAt(unsigned int position, unsigned int& length, SDL_Rect& bounds) const
+{
+  if ( position >= layerStart_.size() || layerStart_[position] < 0 ) return nullptr;
+  const Layer& layer = layers_[ layerStart_[position] ];
+  length = layer.items.size();
+  bounds = layer.bounds;
+  return layer.texture;
+}
+
+
+
+void
+SlLayerCache::update(SDL_Renderer* renderer, SlRenderState& state, const std::vector<SlRenderItem*>& queue, int width, int height)
+{
+  //! Static items: unchanged for long enough, and drawn with a blend mode that gives the same result through a layer.
+  std::vector<bool> isStatic( queue.size(), false );
+  for ( unsigned int i = 0 ; i < queue.size() ; ++i ) {
+    SlRenderItem* item = queue[i];
+    unsigned long version;
+    if ( !itemVersion(item, version) ) continue;
+    if ( version != item->seenVersion_ ) {
+      item->seenVersion_ = version;
+      item->unchangedFrames_ = 0;
+    }
+    else if ( item->unchangedFrames_ < staticFrames ) {
+      ++item->unchangedFrames_;
+    }
+    if ( item->unchangedFrames_ < staticFrames ) continue;
+    SDL_BlendMode blendMode = state.defaultBlendMode( item->sprite_->texture()->texture() );
+    isStatic[i] = ( blendMode == SDL_BLENDMODE_NONE || blendMode == SDL_BLENDMODE_BLEND );
+  }
+
+  for ( auto iter = layers_.begin(); iter != layers_.end(); ) {
+    if ( isValid(*iter, queue) ) {
+      ++iter;
+    }
+    else {
+      SDL_DestroyTexture( iter->texture );
+      iter = layers_.erase(iter);
+    }
+  }
+
+  std::vector<bool> isCached( queue.size(), false );
+  for ( auto& layer: layers_ ) {
+    for ( unsigned int i = 0 ; i < layer.items.size() ; ++i ) isCached[layer.first + i] = true;
+  }
+  unsigned int i = 0;
+  while ( i < queue.size() && layers_.size() < maxLayers && canCreate_ ) {
+    if ( isCached[i] || !isStatic[i] ) {
+      ++i;
+      continue;
+    }
+    unsigned int last = i;
+    while ( last < queue.size() && isStatic[last] && !isCached[last] ) ++last;
+    if ( last - i >= minItems ) build( renderer, state, queue, i, last, width, height );
+    i = last;
+  }
+
+  layerStart_.assign( queue.size(), -1 );
+  for ( unsigned int index = 0 ; index < layers_.size() ; ++index ) {
+    layerStart_[ layers_[index].first ] = index;
+  }
+}
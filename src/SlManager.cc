@@ -7,14 +7,16 @@
 */
 
 #include <iostream>
-#include <fstream>
-#include <sstream>
 #include <string>
+#include <string_view>
 #include <stdexcept>
 #include <memory>
 #include <algorithm>
 #include <iterator>
+#include <cmath>
 
+#include "SlConfigReader.h"
+#include "SlSceneCache.h"
 #include "SlTexture.h"
 #include "SlSprite.h"
 #include "SlRenderItem.h"
@@ -46,9 +48,13 @@ SlManager::SlManager(const std::string& name, int width, int height)
 
 SlManager::~SlManager(void)
 {
+  if ( !profileFile_.empty() && !profiler_.writeCsv(profileFile_) )
+    std::cerr << "[SlManager::~SlManager] Couldn't write profile to " << profileFile_ << std::endl;
   this->clear();
   smngr_ = nullptr;
   tmngr_ = nullptr;
+  if ( canvas_ ) SDL_DestroyTexture(canvas_);
+  canvas_ = nullptr;
   SDL_DestroyRenderer(renderer_);
   renderer_ = nullptr;
   SDL_DestroyWindow( window_ );
@@ -66,6 +72,7 @@ SlManager::appendToRenderQueue(const std::string& name, unsigned int destination
   toAdd = createRenderItem(name, destination);
   if ( toAdd ) {
     renderQueue_.push_back(toAdd);
+    toAdd->markDirty();
   }
   else {
 #ifdef DEBUG
@@ -86,11 +93,13 @@ SlManager::clear()
   }
   renderManip_.clear();
 
-  std::vector<SlRenderItem*>::iterator item;
+  SlRenderQueue::const_iterator item;
   for ( item = renderQueue_.begin(); item != renderQueue_.end() ; ++item) {
     delete (*item);
   }
   renderQueue_.clear();
+  drawList_.clear();
+  layers_.clear();
 }
 
 
@@ -122,13 +131,30 @@ SlManager::createRenderItem(const std::string& name, unsigned int destination)
 void
 SlManager::deleteRenderItem(const std::string& name)
 {
-  std::vector<SlRenderItem*>::iterator item = renderQueue_.end() ;
-  while ( item != renderQueue_.begin() ) {
-    --item;
-    if ( (*item)->sprite_->name() == name ) {
-      delete (*item);
-      renderQueue_.erase(item);
-    }
+  std::shared_ptr<SlSprite> sprite;
+  try {
+    sprite = smngr_->findSprite(name);
+  }
+  catch (const std::invalid_argument& expt) {
+    return;
+  }
+  std::vector<SlRenderItem*> removed = renderQueue_.eraseSprite( sprite.get() );
+  for ( auto item: removed ) {
+    item->markDirty();
+    delete item;
+  }
+}
+
+
+
+int
+SlManager::findInRenderQueue(const std::string& name, unsigned int destination)
+{
+  try {
+    return renderQueue_.find( smngr_->findSprite(name).get(), destination );
+  }
+  catch (const std::invalid_argument& expt) {
+    return -1;
   }
 }
 
@@ -191,9 +217,12 @@ SlManager::initialize()
   
   valParser_ = SlValueParser();
   tmngr_ = std::unique_ptr<SlTextureManager>(new SlTextureManager( this ));
+  tmngr_->keepImagesForAtlas(atlasSize_);
   //  smngr_ = std::make_unique<SlSpriteManager>( this );
   smngr_ = std::shared_ptr<SlSpriteManager>(new SlSpriteManager( this )); //!< Needs to be shared with SlRenderQueueManipulation items.
   eventHandler_ = std::unique_ptr<SlEventHandler>( new SlEventHandler() );
+  eventHandler_->setProfiler( &profiler_ );
+  batch_ = std::unique_ptr<SlRenderBatch>( new SlRenderBatch( &renderState_ ) );
 }
 
 
@@ -213,8 +242,12 @@ SlManager::initializeWindow(const std::string& name, int width, int height)
     std::cerr << "Renderer could not be created " <<  SDL_GetError() << std::endl;
     exit(1);
   }
+  SDL_RendererInfo info;
+  hasVsync_ = ( SDL_GetRendererInfo(renderer_, &info) == 0 && (info.flags & SDL_RENDERER_PRESENTVSYNC) );
   
   valParser_.setDimensions(screen_width_, screen_height_);
+  dirtyRegion_.setBounds(screen_width_, screen_height_);
+  renderQueue_.spatialGrid()->setBounds(screen_width_, screen_height_);
   // tmngr_ = std::unique_ptr<SlTextureManager>(new SlTextureManager( this ));
   // smngr_ = std::shared_ptr<SlSpriteManager>(new SlSpriteManager( this )); //!< Needs to be shared with SlRenderQueueManipulation items.
 
@@ -250,6 +283,12 @@ SlManager::initializeWindow(const std::string& name, int width, int height)
   renderManip_[toAdd->name()] = toAdd;
   toAdd = new SlRMmoveActiveBy( smngr_.get(), &valParser_, &renderQueue_ );
   renderManip_[toAdd->name()] = toAdd;
+  toAdd = new SlRMpick( smngr_.get(), &valParser_, &renderQueue_ );
+  renderManip_[toAdd->name()] = toAdd;
+  toAdd = new SlRMmovePickedBy( smngr_.get(), &valParser_, &renderQueue_ );
+  renderManip_[toAdd->name()] = toAdd;
+  toAdd = new SlRMdrop( smngr_.get(), &valParser_, &renderQueue_ );
+  renderManip_[toAdd->name()] = toAdd;
 
   eventHandler_->addManipulations( renderManip_ );
   eventHandler_->addManipulations( smngr_->manipulations() );
@@ -264,16 +303,13 @@ SlManager::insertInRenderQueueAfter(const std::string& toAdd, const std::string&
   if ( toInsert == nullptr ) 
     throw std::runtime_error( "[SlManager::insertInRenderQueueAfter] Couldn't create SlRenderItem for " + toAdd ) ;
 
-  std::vector<SlRenderItem*>::iterator iter;
-  for ( iter = renderQueue_.begin(); iter != renderQueue_.end() ; ++iter) {
-    if ( ( (*iter)->sprite_->name() ==  afterThis ) && ( (*iter)->destination_ == destAfterThis ) ) {
-      renderQueue_.insert( (++iter), toInsert );
-      return;
-    }
-  }
-
-  if ( iter == renderQueue_.end() ) 
+  int position = findInRenderQueue(afterThis, destAfterThis);
+  if ( position < 0 ) {
+    delete toInsert;
     throw std::runtime_error( "[SlManager::insertInRenderQueueAfter] Couldn't find RenderItem " + afterThis + " to insert after." );
+  }
+  renderQueue_.insert( position + 1, toInsert );
+  toInsert->markDirty();
 }
 
 
@@ -286,16 +322,13 @@ SlManager::insertInRenderQueueBefore(const std::string& toAdd, const std::string
   if ( toInsert == nullptr ) 
     throw std::runtime_error( "[SlManager::insertInRenderQueueBefore] Couldn't create SlRenderItem for " + toAdd );
 
-  std::vector<SlRenderItem*>::iterator iter;
-  for ( iter = renderQueue_.begin(); iter != renderQueue_.end() ; ++iter) {
-    if ( ( (*iter)->sprite_->name() ==  beforeThis ) && ( (*iter)->destination_ == destBeforeThis ) ) {
-      renderQueue_.insert( (iter), toInsert );
-      return;
-    }
-  }
-
-  if ( iter == renderQueue_.end() )
+  int position = findInRenderQueue(beforeThis, destBeforeThis);
+  if ( position < 0 ) {
+    delete toInsert;
     throw std::runtime_error( "[SlManager::insertInRenderQueueBefore] Couldn't find RenderItem " + beforeThis + " to insert before." );
+  }
+  renderQueue_.insert( position, toInsert );
+  toInsert->markDirty();
 }
 
 
@@ -317,41 +350,26 @@ SlManager::moveInRenderQueue(const std::string& toMoveName, const std::string& t
 {
   bool isMoved = false;
   
-  auto iter1 = std::find_if( renderQueue_.begin(), renderQueue_.end(),
-			     [toMoveName, destToMove](const SlRenderItem* item) -> bool { return ( (item)->sprite_->name() == toMoveName && (item)->destination_ == destToMove ); } );
-  if ( iter1 == renderQueue_.end() ) {
+  int toMove = findInRenderQueue(toMoveName, destToMove);
+  if ( toMove < 0 ) {
 #ifdef DEBUG
     std::cout << "[SlManager::moveInRenderQueueAfter] Couldn't find item to move " << toMoveName   << std::endl;
 #endif
     return isMoved;
   }
 
-  auto iter2 = std::find_if( renderQueue_.begin(), renderQueue_.end(),
-			     [targetName, targetDest](const SlRenderItem* item) -> bool { return ( (item)->sprite_->name() == targetName && (item)->destination_ == targetDest ); } );
-  if ( iter2 == renderQueue_.end() ) {
+  int target = findInRenderQueue(targetName, targetDest);
+  if ( target < 0 ) {
 #ifdef DEBUG
     std::cout << "[SlManager::moveInRenderQueueAfter] Couldn't find RenderItem to insert after: " << targetName << std::endl;
 #endif
     return isMoved;
   }
 
-  if ( iter1 == iter2 ) 
-    return isMoved;
-
-  /* Cheat sheet
-    std::rotate( iter2, iter1, iter1+1 );   // insert before, iter1 > iter 2
-    std::rotate( iter2+1, iter1, iter1+1 );  // insert after, iter1 > iter 2
-    std::rotate( iter1, iter1+1, iter2 );   // insert before, iter1 < iter 2
-    std::rotate( iter1, iter1+1, iter2+1 );  // insert after, iter1 < iter 2
-  */
-
-  if ( iter1 > iter2 )
-    std::rotate( iter2 + beforeOrAfter, iter1, iter1+1 ); 
-  else if ( iter1 < iter2 ) {
-    std::rotate( iter1, iter1+1, iter2 + beforeOrAfter );
-  }
-  else
+  if ( toMove == target ) 
     return isMoved;
+  renderQueue_[toMove]->markDirty();
+  renderQueue_.move(toMove, target, beforeOrAfter);
 
   isMoved = true;
   return isMoved;
@@ -377,52 +395,75 @@ SlManager::moveInRenderQueueBefore(const std::string& toMoveName, const std::str
 
 
 
+SlRenderItem*
+SlManager::pickAt(int x, int y)
+{
+  int position = renderQueue_.pick(x, y);
+  if ( position < 0 ) return nullptr;
+  return renderQueue_[position];
+}
+
+
+
 bool
 SlManager::parseConfigurationFile(const std::string& filename)
 {
   bool result = true;
-  std::ifstream input(filename,std::ifstream::in);
-  if ( !input.is_open() ) 
-    throw std::runtime_error("[SlManager::parseConfigurationFile] Couldn't open file " + filename );
+  std::string cacheName = filename + ".slc";
+  SlSceneCache scene;
+  if ( sceneCaching_ && scene.read( cacheName, filename, screen_width_, screen_height_ ) ) {
+#ifdef DEBUG
+    std::cout << "[SlManager::parseConfigurationFile] Loading " << cacheName << std::endl;
+#endif
+    replayScene(scene);
+    tmngr_->releasePrefetched();
+    return result;
+  }
+  SlSceneCache* recording = ( sceneCaching_ ? &scene : nullptr );
+  SlConfigReader input(filename);
+  {
+    SlConfigReader prefetch(filename);
+    tmngr_->prefetchImages(prefetch);
+  }
   
-  std::string line, token;
-  getline(input,line);
-  while ( input )
+  while ( input.nextLine() )
     {
-      std::istringstream stream(line.c_str());
-      stream >> token;
-      if ( token[0] == '#' || token.empty() || token[0] == '\n' ) {
+      std::string_view token = input.next();
+      if ( token.empty() || token[0] == '#' ) {
 	/* empty line or comment */
       }
       else if ( token == "texture" ) {
-	SlTexture* newTexture = tmngr_->parseTexture( input );
+	SlTexture* newTexture = tmngr_->parseTexture( input, recording );
 	if ( newTexture ) smngr_->createSprite(newTexture);
       }
       else if ( token == "sprite" ) {
-	smngr_->parseSprite(input);
+	smngr_->parseSprite( input, recording );
       }
       else if ( token == "manipulate" ) {
-	smngr_->parseSpriteManipulation(input);
+	smngr_->parseSpriteManipulation( input, recording );
       }
       else if ( token == "font" ) {
-	tmngr_->parseFont( input );
+	tmngr_->parseFont( input, recording );
       }
       else if ( token == "renderqueue" ) {
-	parseRenderQueueManipulation( input );
+	parseRenderQueueManipulation( input, recording );
       }
       else if ( token == "event" ) {
-	eventHandler_->parseEvent( input );
+	eventHandler_->parseEvent( input, recording );
       }
       else {
 #ifdef DEBUG
-	std::cerr << "[SlManager::parseConfigurationFile] Unknown token " << token << std::endl;
+	std::cerr << "[SlManager::parseConfigurationFile] Unknown token " << token << " in " << input.filename() << ":" << input.lineNumber() << std::endl;
 #endif
       }
-	
-      token.clear();
-      if ( input) getline(input,line);
     }
 
+  tmngr_->releasePrefetched();
+  if ( recording && !scene.write( cacheName, filename, screen_width_, screen_height_ ) ) {
+#ifdef DEBUG
+    std::cerr << "[SlManager::parseConfigurationFile] Couldn't write scene cache " << cacheName << std::endl;
+#endif
+  }
   return result;
 }
 
@@ -431,57 +472,149 @@ SlManager::parseConfigurationFile(const std::string& filename)
 void
 SlManager::parseIniFile(const std::string& filename)
 {
-  std::ifstream input(filename,std::ifstream::in);
-  if ( !input.is_open() ) 
-    throw std::runtime_error("[SlManager::parseIniFile] Couldn't open ini file " + filename );
+  SlConfigReader input(filename);
   
-  std::string line, token, name;
-  getline(input,line);
-  while ( input )
+  while ( input.nextLine() )
     {
-      std::istringstream stream(line.c_str());
-      stream >> token;
-      if ( token[0] == '#' || token.empty() || token[0] == '\n' ) {
+      std::string_view token = input.next();
+      if ( token.empty() || token[0] == '#' ) {
 	/* empty line or comment */
       }
       else if ( token == "window" ) {
-	std::string name;
-	stream >> name;
-	std::istream_iterator<unsigned int> uint_iter(stream), eof;
-	std::vector<unsigned int> dims(uint_iter, eof);
-	initializeWindow( name, dims.at(0), dims.at(1) );
+	std::string name( input.next() );
+	unsigned int dims[2];
+	if ( !input.next(dims[0]) || !input.next(dims[1]) )
+	  throw std::out_of_range("[SlManager::parseIniFile] Window dimensions missing in " + filename + ":" + std::to_string( input.lineNumber() ) );
+	initializeWindow( name, dims[0], dims[1] );
       }
       else if ( token == "file" ) {
-	std::string filename;
-	stream >> filename;
-	parseConfigurationFile(filename);
+	parseConfigurationFile( std::string( input.next() ) );
+      }
+      else if ( token == "batch" ) {
+	int batch = 0;
+	input.next(batch);
+	setBatchRendering( batch != 0 );
+      }
+      else if ( token == "dirty" ) {
+	int dirty = 0;
+	input.next(dirty);
+	setDirtyRendering( dirty != 0 );
+      }
+      else if ( token == "layers" ) {
+	int layers = 0;
+	input.next(layers);
+	setLayerCaching( layers != 0 );
+      }
+      else if ( token == "occlusion" ) {
+	int occlusion = 1;
+	input.next(occlusion);
+	setOcclusionCulling( occlusion != 0 );
+      }
+      else if ( token == "atlas" ) {
+	int size = atlasSize_;
+	input.next(size);
+	setAtlasSize(size);
+      }
+      else if ( token == "profile" ) {
+	unsigned int frames = 0;
+	input.next(frames);
+	profileFile_ = input.next();
+	profiler_.setCapacity(frames);
+      }
+      else if ( token == "fps" ) {
+	input.next(targetFps_);
+      }
+      else if ( token == "updaterate" ) {
+	double rate = updateRate_;
+	unsigned int maxUpdates = maxUpdates_;
+	if ( input.next(rate) ) input.next(maxUpdates);
+	setUpdateRate( rate, maxUpdates );
+      }
+      else if ( token == "coalesce" ) {
+	int coalesce = 1;
+	input.next(coalesce);
+	setMotionCoalescing( coalesce != 0 );
+      }
+      else if ( token == "scenecache" ) {
+	int caching = 0;
+	input.next(caching);
+	setSceneCaching( caching != 0 );
+      }
+      else if ( token == "texturebudget" ) {
+	unsigned int megabytes = 0;
+	input.next(megabytes);
+	setTextureBudget( static_cast<std::size_t>(megabytes) << 20 );
+      }
+      else if ( token == "onchange" ) {
+	int onChange = 0, maxWait = -1;
+	if ( input.next(onChange) ) input.next(maxWait);
+	setRunOnChange( onChange != 0, maxWait );
       }
       else {
 #ifdef DEBUG
-	std::cerr << "[SlManager::parseConfigurationFile] Unknown token " << token << std::endl;
+	std::cerr << "[SlManager::parseIniFile] Unknown token " << token << " in " << input.filename() << ":" << input.lineNumber() << std::endl;
 #endif
       }
-	
-      token.clear();
-      if ( input) getline(input,line);
     }
+  packTextures();
+}
+
+
+
+void
+SlManager::manageTextureBudget()
+{
+  tmngr_->nextFrame();
+  bool isReloaded = false;
+  //! Only items that renderItems() doesn't cull count as used, so that textures of off-screen items can be evicted.
+  SDL_Rect screen = {0, 0, screen_width_, screen_height_};
+  for ( unsigned int i = 0 ; i < drawList_.size() ; ++i ) {
+    const SlDrawCommand& command = drawList_[i];
+    if ( !command.renderMe || !SDL_HasIntersection( &command.bounds, &screen ) ) continue;
+    SlRenderItem* item = renderQueue_[i];
+    try {
+      if ( tmngr_->touchTexture( item->sprite_->texture() ) ) isReloaded = true;
+    }
+    catch (const std::exception& expt){
+      std::cerr << "[SlManager::manageTextureBudget] " << item->name() << ": " << expt.what() << std::endl;
+    }
+  }
+  //! The draw list still holds the destroyed SDL_Textures of the reloaded textures.
+  if ( isReloaded ) {
+    for ( unsigned int i = 0 ; i < drawList_.size() ; ++i )
+      drawList_[i].texture = renderQueue_[i]->sprite_->texture()->texture();
+  }
+  tmngr_->enforceBudget();
+}
+
+
+
+unsigned int
+SlManager::packTextures()
+{
+  if ( atlasSize_ <= 0 ) return 0;
+  std::vector<SlTexture*> moved = tmngr_->packAtlas(atlasSize_);
+  for ( auto texture: moved ) {
+    SDL_Rect region = texture->region();
+    smngr_->moveSpriteSources( texture, region.x, region.y );
+  }
+  if ( !moved.empty() ) dirtyRegion_.invalidateAll();
+  return moved.size();
 }
 
 
 
 void
-SlManager::parseRenderQueueManipulation( std::ifstream& input )
+SlManager::parseRenderQueueManipulation( SlConfigReader& input, SlSceneCache* scene )
 {
-  std::string line, token;
   std::string name, whatToDo;
-  unsigned int destination;
+  unsigned int destination = 0;
+  std::vector<std::string> parameters;
   bool endOfConfig = false;
   
-  getline(input,line);
-  while ( !endOfConfig && input ) {
-    std::istringstream stream(line.c_str());
-    stream >> token;
-    if ( token[0] == '#' || token.empty() ) {
+  while ( !endOfConfig && input.nextLine() ) {
+    std::string_view token = input.next();
+    if ( token.empty() || token[0] == '#' ) {
       /* empty line or comment */
     }
     else if ( token == "end" ) {
@@ -490,43 +623,337 @@ SlManager::parseRenderQueueManipulation( std::ifstream& input )
     else {
       try {
 	name = token ;
-	stream >> destination ;
-	stream >> whatToDo ;
-	std::istream_iterator<std::string> str_iter(stream), eof;
-	std::vector<std::string> parameters(str_iter, eof);
+	input.next(destination);
+	whatToDo = input.next();
+	parameters.clear();
+	input.rest(parameters);
 	manipulateRenderQueue( name, destination, whatToDo, parameters );
+	if ( scene )
+	  scene->add( SL_SCENE_RENDERQUEUE, {name, whatToDo}, {static_cast<int>(destination)}, valParser_.resolveFormulas(parameters) );
       }
       catch (const std::exception& expt) {
-	std::cerr << "[SlManager::parseRenderQueueManipulation] " << expt.what() << std::endl;
+	std::cerr << "[SlManager::parseRenderQueueManipulation] " << input.filename() << ":" << input.lineNumber() << ": " << expt.what() << std::endl;
+	if ( scene ) scene->markIncomplete();
       }
       catch (...) {
-	std::cerr << "[SlManager::parseRenderQueueManipulation] Unknown exception at line: " << line << std::endl;
+	std::cerr << "[SlManager::parseRenderQueueManipulation] Unknown exception at line: " << input.line() << std::endl;
+	if ( scene ) scene->markIncomplete();
       }
     }
-    token.clear();
-    if ( !endOfConfig ) getline(input,line);
+    destination = 0;
   }
 }
 
 
 
 void
-SlManager::render()
+SlManager::replayScene(SlSceneCache& scene)
 {
-  SDL_RenderClear( renderer_ );
- 
-  for (auto& item: renderQueue_){
-    if ( item->renderMe_ ) {
-      try {
-        (item->sprite_)->render( renderer_, (item->destination_) );
+  SlSceneCache::Record record;
+  //! Decode all image files in the background first, the loop below only uploads them.
+  while ( scene.next(record) ) {
+    if ( record.op == SL_SCENE_TEXTURE_FILE ) tmngr_->prefetchImage( scene.string(record, 1) );
+  }
+  scene.rewind();
+  while ( scene.next(record) ) {
+    try {
+      SlTexture* newTexture = nullptr;
+      switch ( record.op ) {
+      case SL_SCENE_TEXTURE_FILE:
+	newTexture = tmngr_->createTextureFromFile( scene.string(record, 0), scene.string(record, 1) );
+	break;
+      case SL_SCENE_TEXTURE_ASYNC:
+	newTexture = tmngr_->createTextureAsync( scene.string(record, 0), scene.string(record, 1) );
+	break;
+      case SL_SCENE_TEXTURE_TILE:
+	newTexture = tmngr_->createTextureFromTile( scene.string(record, 0), scene.string(record, 1), scene.number(record, 0), scene.number(record, 1) );
+	break;
+      case SL_SCENE_TEXTURE_RECTANGLE:
+	newTexture = tmngr_->createTextureFromRectangle( scene.string(record, 0), scene.number(record, 0), scene.number(record, 1),
+							 scene.number(record, 2), scene.number(record, 3), scene.number(record, 4), scene.number(record, 5) );
+	break;
+      case SL_SCENE_TEXTURE_SPRITE_ON_TEXTURE:
+	newTexture = tmngr_->createTextureFromSpriteOnTexture( scene.string(record, 0), scene.string(record, 1), scene.string(record, 2) );
+	break;
+      case SL_SCENE_TEXTURE_TEXT:
+	newTexture = tmngr_->createTextureFromText( scene.string(record, 0), scene.string(record, 1), scene.string(record, 2), scene.number(record, 0) );
+	break;
+      case SL_SCENE_FONT: {
+	short color[4];
+	for ( unsigned int i = 0 ; i < 4 ; ++i ) color[i] = scene.number(record, i+1);
+	tmngr_->createFont( scene.string(record, 0), scene.string(record, 1), scene.number(record, 0), color );
+	break;
       }
-      catch (const std::runtime_error& expt){
-	std::cerr << expt.what() << std::endl;
+      case SL_SCENE_SPRITE:
+	smngr_->createSprite( scene.string(record, 0), scene.string(record, 1), scene.number(record, 0), scene.number(record, 1), scene.number(record, 2), scene.number(record, 3) );
+	break;
+      case SL_SCENE_SPRITE_MANIPULATION:
+	smngr_->manipulateSprite( scene.string(record, 0), scene.number(record, 0), scene.string(record, 1), scene.list(record) );
+	break;
+      case SL_SCENE_RENDERQUEUE:
+	manipulateRenderQueue( scene.string(record, 0), scene.number(record, 0), scene.string(record, 1), scene.list(record) );
+	break;
+      case SL_SCENE_EVENT:
+	eventHandler_->addAction( scene.string(record, 0), scene.string(record, 1), scene.string(record, 2), scene.number(record, 0), scene.list(record) );
+	break;
       }
+      if ( newTexture ) smngr_->createSprite(newTexture);
+    }
+    catch (const std::exception& expt) {
+      std::cerr << "[SlManager::replayScene] " << expt.what() << std::endl;
     }
   }
+}
+
+
+
+void
+SlManager::render()
+{
+  profiler_.begin(SL_PHASE_RENDER);
+  renderState_.beginFrame();
+  renderStats_.reset();
+  batch_->resetCounters();
+  //! packTextures() is done before the first frame, nothing uses the images kept for it after that.
+  tmngr_->releaseAtlasImages();
+  if ( eventHandler_->targetsReset ) {
+    //! The layers and the dirty-rectangle canvas are render targets, their contents are gone.
+    layers_.clear();
+    dirtyRegion_.invalidateAll();
+    eventHandler_->targetsReset = false;
+  }
+  compileDrawList();
+  if ( tmngr_->textureBudget() > 0 ) manageTextureBudget();
+  if ( layerCaching_ ) layers_.update( renderer_, renderState_, renderQueue_.items(), screen_width_, screen_height_ );
+
+  if ( dirtyRendering_ ) {
+    renderDirty();
+  }
+  else {
+    SDL_Rect screen = {0, 0, screen_width_, screen_height_};
+    if ( !findOccluded(screen) ) SDL_RenderClear( renderer_ );
+    renderItems();
+  }
 
+  renderStats_.drawCalls += batch_->drawCalls();
+  profiler_.end(SL_PHASE_RENDER);
+  profiler_.begin(SL_PHASE_PRESENT);
   SDL_RenderPresent( renderer_ );
+  profiler_.end(SL_PHASE_PRESENT);
+  dirtyRegion_.clear();
+}
+
+
+
+void
+SlManager::renderDirty()
+{
+  if ( canvas_ == nullptr ) {
+    canvas_ = SDL_CreateTexture(renderer_, 0, SDL_TEXTUREACCESS_TARGET, screen_width_, screen_height_);
+    if ( canvas_ == nullptr ) {
+      std::cerr << "[SlManager::renderDirty] Couldn't create canvas, turning off dirty rendering: " << SDL_GetError() << std::endl;
+      dirtyRendering_ = false;
+      SDL_Rect screen = {0, 0, screen_width_, screen_height_};
+      if ( !findOccluded(screen) ) SDL_RenderClear( renderer_ );
+      renderItems();
+      return;
+    }
+    SDL_SetTextureBlendMode( canvas_, SDL_BLENDMODE_NONE );
+    dirtyRegion_.invalidateAll();
+  }
+
+  if ( !dirtyRegion_.isEmpty() ) {
+    SDL_SetRenderTarget( renderer_, canvas_ );
+    const std::vector<SDL_Rect>& rects = dirtyRegion_.merge();
+    if ( dirtyRegion_.isFull() ) {
+      SDL_Rect screen = {0, 0, screen_width_, screen_height_};
+      if ( !findOccluded(screen) ) SDL_RenderClear( renderer_ );
+      renderItems();
+    }
+    else {
+      for ( auto& rect: rects ) {
+	//! SDL_RenderClear ignores the clip rectangle, fill with the draw colour instead.
+	SDL_RenderSetClipRect( renderer_, &rect );
+	if ( !findOccluded(rect) ) SDL_RenderFillRect( renderer_, &rect );
+	renderItems( &rect );
+      }
+      SDL_RenderSetClipRect( renderer_, nullptr );
+    }
+    SDL_SetRenderTarget( renderer_, nullptr );
+  }
+
+  SDL_RenderCopy( renderer_, canvas_, nullptr, nullptr );
+}
+
+
+
+void
+SlManager::compileDrawList()
+{
+  if ( drawListVersion_ == SlSprite::changeCount() && drawList_.size() == renderQueue_.size() ) return;
+
+  drawList_.resize( renderQueue_.size() );
+  for ( unsigned int i = 0 ; i < renderQueue_.size() ; ++i ) {
+    SlRenderItem* item = renderQueue_[i];
+    SlDrawCommand& command = drawList_[i];
+    try {
+      SlTexture* texture = item->sprite_->texture();
+      command.settings = item->sprite_->renderSettings( item->destination_ );
+      command.texture = texture->texture();
+      command.sourceRect = item->sprite_->sourceRect();
+      command.bounds = item->sprite_->boundingBox( item->destination_ );
+      command.isOccluder = ( texture->isOpaque() && command.settings.angle == 0 &&
+			     (command.settings.renderOptions & SL_RENDER_ALPHAMOD) != SL_RENDER_ALPHAMOD );
+      command.renderMe = item->renderMe_;
+    }
+    catch (const std::exception& expt){
+      std::cerr << "[SlManager::compileDrawList] " << item->name() << " " << item->destination_ << ": " << expt.what() << std::endl;
+      command = SlDrawCommand();
+    }
+  }
+  drawListVersion_ = SlSprite::changeCount();
+}
+
+
+
+bool
+SlManager::findOccluded(const SDL_Rect& area)
+{
+  isOccluded_.assign( drawList_.size(), false );
+  if ( !occlusionCulling_ ) return false;
+
+  //! Containment is only tested against single occluders, a few large ones catch the common cases of backgrounds and panels.
+  const unsigned int maxOccluders = 8;
+  std::vector<SDL_Rect> occluders;
+  bool isCovered = false;
+  for ( int i = drawList_.size() - 1 ; i >= 0 ; --i ) {
+    const SlDrawCommand& command = drawList_[i];
+    if ( !command.renderMe ) continue;
+    SDL_Rect visible;
+    if ( !SDL_IntersectRect( &command.bounds, &area, &visible ) ) continue;
+
+    if ( isCovered ) {
+      isOccluded_[i] = true;
+      continue;
+    }
+    for ( auto& occluder: occluders ) {
+      if ( visible.x >= occluder.x && visible.y >= occluder.y &&
+	   visible.x + visible.w <= occluder.x + occluder.w &&
+	   visible.y + visible.h <= occluder.y + occluder.h ) {
+	isOccluded_[i] = true;
+	break;
+      }
+    }
+    if ( isOccluded_[i] || !command.isOccluder ) continue;
+
+    if ( visible.w == area.w && visible.h == area.h ) {
+      isCovered = true;
+    }
+    else if ( occluders.size() < maxOccluders ) {
+      occluders.push_back(visible);
+    }
+  }
+  return isCovered;
+}
+
+
+
+void
+SlManager::renderLayer(SDL_Texture* layer, unsigned int position, unsigned int length, const SDL_Rect& bounds, const SDL_Rect* clip)
+{
+  renderStats_.cached += length;
+  if ( SDL_RectEmpty( &bounds ) ) return;
+  if ( clip && !SDL_HasIntersection( &bounds, clip ) ) return;
+  bool isHidden = true;
+  for ( unsigned int i = position ; i < position + length && isHidden ; ++i ) {
+    if ( drawList_[i].renderMe && !isOccluded_[i] ) isHidden = false;
+  }
+  if ( isHidden ) return;
+
+  //! Keep the painter's order, everything queued before the layer has to be drawn first.
+  if ( batchRendering_ ) batch_->flush( renderer_ );
+  if ( SDL_RenderCopy( renderer_, layer, &bounds, &bounds ) != 0 )
+    throw std::runtime_error("[SlManager::renderLayer] Error copying layer: " + std::string( SDL_GetError() ) );
+  ++renderStats_.layers;
+  ++renderStats_.drawCalls;
+}
+
+
+
+void
+SlManager::setLayerCaching(bool layers)
+{
+  layerCaching_ = layers;
+  if ( !layerCaching_ ) layers_.clear();
+  dirtyRegion_.invalidateAll();
+}
+
+
+
+void
+SlManager::setMotionCoalescing(bool coalesce)
+{
+  eventHandler_->setMotionCoalescing(coalesce);
+}
+
+
+
+void
+SlManager::renderItems(const SDL_Rect* clip)
+{
+  SDL_Rect screen = {0, 0, screen_width_, screen_height_};
+  for ( unsigned int i = 0 ; i < drawList_.size() ; ++i ) {
+    if ( layerCaching_ ) {
+      unsigned int length = 0;
+      SDL_Rect bounds;
+      SDL_Texture* layer = layers_.layerAt( i, length, bounds );
+      if ( layer ) {
+	try {
+	  renderLayer( layer, i, length, bounds, clip );
+	}
+	catch (const std::exception& expt){
+	  std::cerr << expt.what() << std::endl;
+	}
+	i += length - 1;
+	continue;
+      }
+    }
+    const SlDrawCommand& command = drawList_[i];
+    if ( !command.renderMe ) continue;
+    if ( !SDL_HasIntersection( &command.bounds, &screen ) ) {
+      ++renderStats_.culled;
+      continue;
+    }
+    if ( clip && !SDL_HasIntersection( &command.bounds, clip ) ) continue;
+    if ( i < isOccluded_.size() && isOccluded_[i] ) {
+      ++renderStats_.occluded;
+      continue;
+    }
+    ++renderStats_.drawn;
+    try {
+      if ( batchRendering_ ) {
+	batch_->add( renderer_, command.texture, command.sourceRect, command.settings );
+      }
+      else {
+	renderState_.apply( command.texture, command.settings );
+	++renderStats_.drawCalls;
+	if ( SDL_RenderCopyEx( renderer_, command.texture, &command.sourceRect, &command.settings.destinationRect, command.settings.angle, NULL, SDL_FLIP_NONE ) != 0 )
+	  throw std::runtime_error("[SlManager::renderItems] Error rendering item " + std::to_string(i) + ": " + std::string( SDL_GetError() ) );
+      }
+    }
+    catch (const std::exception& expt){
+      std::cerr << expt.what() << std::endl;
+    }
+  }
+
+  if ( batchRendering_ ) {
+    try {
+      batch_->flush( renderer_ );
+    }
+    catch (const std::runtime_error& expt){
+      std::cerr << expt.what() << std::endl;
+    }
+  }
 }
 
 
@@ -534,14 +961,154 @@ SlManager::render()
 void
 SlManager::run()
 {
+  if ( runOnChange_ ) {
+    runOnChange();
+    return;
+  }
+  uint64_t frequency = SDL_GetPerformanceFrequency();
+  uint64_t deadline = SDL_GetPerformanceCounter();
+  lastTick_ = deadline;
+  accumulator_ = 0;
+
   int quit = 0;
   while ( !quit ) {
+    profiler_.beginFrame();
     quit = eventHandler_->pollEvent();
+    runUpdates();
+    streamTextures();
     render();
+
+    if ( !hasVsync_ && targetFps_ > 0 ) {
+      uint64_t period = frequency / targetFps_;
+      uint64_t now = SDL_GetPerformanceCounter();
+      deadline += period;
+      if ( now < deadline ) {
+	SDL_Delay( static_cast<uint32_t>( (deadline - now) * 1000 / frequency ) );
+      }
+      else {
+	//! More than a frame late, start counting again instead of rushing to catch up.
+	deadline = now;
+      }
+    }
+    profiler_.endFrame();
+  }
+}
+
+
+
+void
+SlManager::runOnChange()
+{
+  render();
+  eventHandler_->redrawRequested = false;
+  lastTick_ = SDL_GetPerformanceCounter();
+  accumulator_ = 0;
+
+  int quit = 0;
+  while ( !quit ) {
+    profiler_.beginFrame();
+    int timeout = maxWait_;
+    if ( updateCallback_ && updateRate_ > 0 ) {
+      int step = static_cast<int>( std::ceil( (1.0 / updateRate_ - accumulator_) * 1000 ) );
+      step = std::max( step, 1 );
+      timeout = ( timeout < 0 ? step : std::min( timeout, step ) );
+    }
+    //! Look for decoded images every few ms while textures are streaming.
+    const int streamPoll = 10;
+    if ( tmngr_->isStreaming() ) timeout = ( timeout < 0 ? streamPoll : std::min( timeout, streamPoll ) );
+    quit = eventHandler_->waitEvent( timeout );
+    runUpdates();
+    streamTextures();
+    if ( !quit && ( eventHandler_->redrawRequested || !dirtyRegion_.isEmpty() ) ) {
+      render();
+      eventHandler_->redrawRequested = false;
+    }
+    profiler_.endFrame();
   }
 }
 
 
+void
+SlManager::setAtlasSize(int size)
+{
+  atlasSize_ = size;
+  tmngr_->keepImagesForAtlas(size);
+}
+
+
+
+bool
+SlManager::setBatchRendering(bool batch)
+{
+#if SL_HAVE_RENDER_GEOMETRY
+  batchRendering_ = batch;
+#else
+  batchRendering_ = false;
+  if ( batch )
+    std::cerr << "[SlManager::setBatchRendering] Batched rendering needs SDL 2.0.18 or newer." << std::endl;
+#endif
+  return ( batchRendering_ == batch );
+}
+
+
+
+void
+SlManager::setDirtyRendering(bool dirty)
+{
+  dirtyRendering_ = dirty;
+  dirtyRegion_.invalidateAll();
+}
+
+
+
+void
+SlManager::runUpdates()
+{
+  uint64_t now = SDL_GetPerformanceCounter();
+  double elapsed = static_cast<double>( now - lastTick_ ) / SDL_GetPerformanceFrequency();
+  lastTick_ = now;
+  if ( !updateCallback_ || updateRate_ <= 0 ) return;
+
+  double step = 1.0 / updateRate_;
+  accumulator_ += elapsed;
+  profiler_.begin(SL_PHASE_UPDATE);
+  unsigned int steps = 0;
+  while ( accumulator_ >= step && steps < maxUpdates_ ) {
+    updateCallback_( step );
+    accumulator_ -= step;
+    ++steps;
+  }
+  profiler_.end(SL_PHASE_UPDATE);
+  //! Updates take longer than real time, drop the whole steps of the backlog so that it doesn't keep growing, but keep the phase.
+  if ( accumulator_ >= step ) {
+#ifdef DEBUG
+    std::cout << "[SlManager::runUpdates] Falling behind, dropping " << static_cast<int>( accumulator_ / step ) << " update steps." << std::endl;
+#endif
+    accumulator_ = std::fmod( accumulator_, step );
+  }
+}
+
+
+
+void
+SlManager::setUpdateRate(double rate, unsigned int maxUpdates)
+{
+  updateRate_ = rate;
+  maxUpdates_ = std::max( maxUpdates, 1u );
+  accumulator_ = 0;
+}
+
+
+
+void
+SlManager::setRunOnChange(bool onChange, int maxWait)
+{
+  runOnChange_ = onChange;
+  maxWait_ = maxWait;
+}
+
+
+
 void
 SlManager::setSpriteColor(const std::string& name, uint8_t red, uint8_t green, uint8_t blue, uint8_t alpha, unsigned int destination)
 {
@@ -567,6 +1134,20 @@ SlManager::setSpriteRenderOptions(const std::string& name, uint32_t renderOption
 
 
 
+unsigned int
+SlManager::streamTextures()
+{
+  if ( !tmngr_->isStreaming() ) return 0;
+  std::vector<SlTexture*> replaced = tmngr_->streamTextures();
+  for ( auto texture: replaced ) {
+    smngr_->resizeSpriteSources( texture, SlTexture::placeholderRegion(), texture->region() );
+  }
+  if ( !replaced.empty() ) dirtyRegion_.invalidateAll();
+  return replaced.size();
+}
+
+
+
 void
 SlManager::swapInRenderQueue(const std::string& toAdd, const std::string& toRemove, unsigned int destToAdd, unsigned int destToRemove)
 {
@@ -574,17 +1155,15 @@ SlManager::swapInRenderQueue(const std::string& toAdd, const std::string& toRemo
   if ( item == nullptr )
     throw std::runtime_error( "[SlManager::swapInRenderQueue] Couldn't create SlRenderItem for " + toAdd );
 
-  std::vector<SlRenderItem*>::iterator iter;
-  for ( iter = renderQueue_.begin(); iter != renderQueue_.end() ; ++iter) {
-    if ( ( (*iter)->sprite_->name() ==  toRemove ) && ( (*iter)->destination_ == destToRemove ) ) {
-      delete (*iter);
-      *iter = item;
-      return;
-    }
-  }
-
-  if ( iter == renderQueue_.end() )
+  int position = findInRenderQueue(toRemove, destToRemove);
+  if ( position < 0 ) {
+    delete item;
     throw std::runtime_error( "[SlManager::swapInRenderQueue] Couldn't find RenderItem " + toRemove + " to swap for." );
+  }
+  SlRenderItem* old = renderQueue_.replace(position, item);
+  old->markDirty();
+  delete old;
+  item->markDirty();
 }
 
 
@@ -599,10 +1178,10 @@ SlManager::swapInRenderQueueAtPosition(const std::string& toAdd, unsigned int de
   if ( item == nullptr )
     throw std::runtime_error( "[SlManager::swapInRenderQueue] Couldn't create SlRenderItem for " + toAdd );
 
-  std::vector<SlRenderItem*>::iterator iter = renderQueue_.begin() + position;
-  delete (*iter);
-  renderQueue_.erase( iter );
-  renderQueue_.insert( iter, item );
+  SlRenderItem* old = renderQueue_.replace(position, item);
+  old->markDirty();
+  delete old;
+  item->markDirty();
 }
 
 
@@ -622,26 +1201,31 @@ SlManager::toggleRender(const std::string& toToggle, unsigned int destination, i
   if ( (onOrOff < -1) || (onOrOff > 1) )
     throw std::invalid_argument( "[SlManager::toggleRender] Unknown onOrOff selection " + std::to_string( onOrOff ) );
 
-  std::vector<SlRenderItem*>::iterator iter;
-  for ( iter = renderQueue_.begin();  iter != renderQueue_.end() ; ++iter) {
-    if ( ( (*iter)->sprite_->name() ==  toToggle ) && ( (*iter)->destination_ == destination ) ) {
-      switch (onOrOff){
-      case -1:
-	(*iter)->renderMe_ = !((*iter)->renderMe_) ;
-	break;
-      case 0:	
-	(*iter)->renderMe_ = false ;
-	break;
-      case 1:
-	(*iter)->renderMe_ = true ;
-	break;
-      }
-      return;
-    }
+  int position = findInRenderQueue(toToggle, destination);
+  if ( position < 0 ) 
+    throw std::runtime_error( "[SlManager::toggleRender] Couldn't toggle sprite " + toToggle + " - sprite not in render queue." );
+
+  SlRenderItem* item = renderQueue_[position];
+  item->markDirty();
+  switch (onOrOff){
+  case -1:
+    item->renderMe_ = !(item->renderMe_) ;
+    break;
+  case 0:	
+    item->renderMe_ = false ;
+    break;
+  case 1:
+    item->renderMe_ = true ;
+    break;
   }
+}
 
-  if ( iter == renderQueue_.end() ) 
-    throw std::runtime_error( "[SlManager::toggleRender] Couldn't toggle sprite " + toToggle + " - sprite not in render queue." );
+
+
+void
+SlManager::wakeUp()
+{
+  eventHandler_->wakeUp();
 }
 
 
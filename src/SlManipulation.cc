@@ -7,6 +7,7 @@
 */
 
 #include <iostream>
+#include <stdexcept>
 
 #include "SlSpriteManager.h"
 #include "SlSprite.h"
@@ -80,3 +81,63 @@ SlManipulation::verifySprite(const std::string& sname, unsigned int destination)
 }
 
 
+
+
+
+void
+SlManipulation::apply(const std::string& name, unsigned int destination, const SlArguments& arguments)
+{
+  if ( !arguments.hasMouse ) {
+    manipulate(name, destination, arguments.parameters);
+    return;
+  }
+  std::vector<std::string> parameters = arguments.parameters;
+  for ( int i = 0 ; i < 4 ; ++i ) parameters.push_back( std::to_string( arguments.mouse[i] ) );
+  manipulate(name, destination, parameters);
+}
+
+
+
+bool
+SlManipulation::coordinates(const SlArguments& arguments, int* values, unsigned int length)
+{
+  if ( arguments.hasMouse ) {
+    if ( length > 4 ) return false;
+    for ( unsigned int i = 0 ; i < length ; ++i ) values[i] = arguments.mouse[i];
+    return true;
+  }
+  if ( arguments.numbers.size() < length ) return false;
+  for ( unsigned int i = 0 ; i < length ; ++i ) {
+    if ( !arguments.isNumber[i] ) return false;
+    values[i] = static_cast<int>( arguments.numbers[i] );
+  }
+  return true;
+}
+
+
+
+void
+SlManipulation::prepareArguments(SlArguments& arguments)
+{
+  if ( valParser ) {
+    //! A quoted formula spans several tokens, evaluate it into one so that the indices of #numbers match the parameters.
+    try {
+      arguments.parameters = valParser->resolveFormulas( arguments.parameters );
+    }
+    catch (const std::exception& expt) {
+      std::cerr << "[SlManipulation::prepareArguments] " << expt.what() << std::endl;
+    }
+  }
+  arguments.numbers.assign( arguments.parameters.size(), 0 );
+  arguments.isNumber.assign( arguments.parameters.size(), false );
+  if ( valParser == nullptr ) return;
+  for ( unsigned int i = 0 ; i < arguments.parameters.size() ; ++i ) {
+    try {
+      valParser->doubleFromString( arguments.parameters[i], arguments.numbers[i] );
+      arguments.isNumber[i] = true;
+    }
+    catch (const std::exception& ) {
+      //! Not a number, e.g. a sprite name or render option.
+    }
+  }
+}
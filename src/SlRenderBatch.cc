@@ -0,0 +1,129 @@
+// part of SDL2lazy
+// author: Ulrike Hager
+
+/*! \file SlRenderBatch.cc
+
+  SlRenderBatch implementation
+*/
+
+#include <cmath>
+#include <string>
+#include <stdexcept>
+
+#include "SlTexture.h"
+#include "SlRenderState.h"
+#include "SlRenderBatch.h"
+
+
+
+SlRenderBatch::SlRenderBatch()
+{
+}
+
+
+
+SlRenderBatch::SlRenderBatch(SlRenderState* state)
+  : state_(state)
+{
+}
+
+
+
+SlRenderBatch::~SlRenderBatch()
+{
+  state_ = nullptr;
+  texture_ = nullptr;
+}
+
+
+
+void
+SlRenderBatch::add(SDL_Renderer* renderer, SDL_Texture* texture, const SDL_Rect& sourceRect, const SlRenderSettings& settings)
+{
+  bool alphaMod = ( (settings.renderOptions & SL_RENDER_ALPHAMOD) == SL_RENDER_ALPHAMOD );
+  SDL_BlendMode blendMode = ( alphaMod ? SDL_BLENDMODE_BLEND : state_->defaultBlendMode( texture ) );
+  if ( texture != texture_ || blendMode != blendMode_ ) {
+    flush(renderer);
+    texture_ = texture;
+    blendMode_ = blendMode;
+    int width = 1, height = 1;
+    SDL_QueryTexture(texture_, nullptr, nullptr, &width, &height);
+    textureWidth_ = width;
+    textureHeight_ = height;
+  }
+
+  SDL_Color color = {0xFF, 0xFF, 0xFF, 0xFF};
+  if ( (settings.renderOptions & SL_RENDER_COLORMOD) == SL_RENDER_COLORMOD ) {
+    color.r = settings.color[0];
+    color.g = settings.color[1];
+    color.b = settings.color[2];
+  }
+  if ( alphaMod ) color.a = settings.color[3];
+
+  const SDL_Rect& dest = settings.destinationRect;
+  float halfWidth = 0.5f * dest.w;
+  float halfHeight = 0.5f * dest.h;
+  float centerX = dest.x + halfWidth;
+  float centerY = dest.y + halfHeight;
+  //! Corners relative to the centre, clockwise from top left, same as SDL_RenderCopyEx rotates around the destination centre.
+  float corners[4][2] = { {-halfWidth, -halfHeight}, {halfWidth, -halfHeight}, {halfWidth, halfHeight}, {-halfWidth, halfHeight} };
+  float u[2] = { sourceRect.x / textureWidth_, (sourceRect.x + sourceRect.w) / textureWidth_ };
+  float v[2] = { sourceRect.y / textureHeight_, (sourceRect.y + sourceRect.h) / textureHeight_ };
+  float texCoords[4][2] = { {u[0], v[0]}, {u[1], v[0]}, {u[1], v[1]}, {u[0], v[1]} };
+
+  double cosAngle = 1, sinAngle = 0;
+  if ( settings.angle != 0 ) {
+    double radians = settings.angle * M_PI / 180.0;
+    cosAngle = std::cos(radians);
+    sinAngle = std::sin(radians);
+  }
+
+  int first = vertices_.size();
+  for ( int i = 0 ; i < 4 ; ++i ) {
+    SDL_Vertex vertex;
+    vertex.position.x = centerX + corners[i][0] * cosAngle - corners[i][1] * sinAngle;
+    vertex.position.y = centerY + corners[i][0] * sinAngle + corners[i][1] * cosAngle;
+    vertex.color = color;
+    vertex.tex_coord.x = texCoords[i][0];
+    vertex.tex_coord.y = texCoords[i][1];
+    vertices_.push_back(vertex);
+  }
+  int quadIndices[6] = { first, first + 1, first + 2, first, first + 2, first + 3 };
+  indices_.insert( indices_.end(), quadIndices, quadIndices + 6 );
+  ++quads_;
+}
+
+
+
+void
+SlRenderBatch::flush(SDL_Renderer* renderer)
+{
+  //! The next batch queries the size again, a destroyed texture's address can be reused by a new texture of another size.
+  SDL_Texture* texture = texture_;
+  texture_ = nullptr;
+  if ( vertices_.empty() ) return;
+
+  //! Colour and alpha are in the vertices, the texture itself has to be unmodulated.
+  state_->setColorMod( texture, 0xFF, 0xFF, 0xFF );
+  state_->setAlphaMod( texture, 0xFF );
+  state_->setBlendMode( texture, blendMode_ );
+
+  int hasRendered = -1;
+#if SL_HAVE_RENDER_GEOMETRY
+  hasRendered = SDL_RenderGeometry( renderer, texture, vertices_.data(), vertices_.size(), indices_.data(), indices_.size() );
+#endif
+  vertices_.clear();
+  indices_.clear();
+  ++drawCalls_;
+  if ( hasRendered != 0 )
+    throw std::runtime_error("[SlRenderBatch::flush] Error rendering batch: " + std::string( SDL_GetError() ) );
+}
+
+
+
+void
+SlRenderBatch::resetCounters()
+{
+  drawCalls_ = 0;
+  quads_ = 0;
+}
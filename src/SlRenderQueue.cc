@@ -0,0 +1,224 @@
+// part of SDL2lazy
+// author: Ulrike Hager
+
+/*! \file SlRenderQueue.cc
+
+  SlRenderQueue implementation
+*/
+
+#include <algorithm>
+
+#include "SlRenderItem.h"
+#include "SlRenderQueue.h"
+
+
+
+SlRenderQueue::SlRenderQueue()
+{
+}
+
+
+
+SlRenderQueue::~SlRenderQueue()
+{
+}
+
+
+
+void
+SlRenderQueue::addToIndex(const SlRenderItem* item, unsigned int position)
+{
+  auto result = index_.emplace( keyOf(item), Entry{position, 1} );
+  if ( !result.second ) {
+    Entry& entry = result.first->second;
+    ++entry.count;
+    if ( position < entry.position ) entry.position = position;
+  }
+}
+
+
+
+void
+SlRenderQueue::clear()
+{
+  items_.clear();
+  index_.clear();
+  grid_.clear();
+  picked_ = Key(nullptr, 0);
+}
+
+
+
+unsigned int
+SlRenderQueue::count(const SlSprite* sprite, unsigned int destination) const
+{
+  auto iter = index_.find( Key(sprite, destination) );
+  if ( iter == index_.end() ) return 0;
+  return iter->second.count;
+}
+
+
+
+SlRenderItem*
+SlRenderQueue::erase(unsigned int position)
+{
+  SlRenderItem* item = items_.at(position);
+  removeFromIndex(item);
+  items_.erase( items_.begin() + position );
+  reindex(position);
+  grid_.touch( item->sprite_.get(), item->destination_ );
+  return item;
+}
+
+
+
+std::vector<SlRenderItem*>
+SlRenderQueue::eraseSprite(const SlSprite* sprite)
+{
+  std::vector<SlRenderItem*> removed;
+  unsigned int first = items_.size();
+  unsigned int kept = 0;
+  for ( unsigned int i = 0 ; i < items_.size() ; ++i ) {
+    if ( items_[i]->sprite_.get() == sprite ) {
+      if ( removed.empty() ) first = i;
+      removeFromIndex( items_[i] );
+      grid_.touch( sprite, items_[i]->destination_ );
+      removed.push_back( items_[i] );
+    }
+    else
+      items_[kept++] = items_[i];
+  }
+  items_.resize(kept);
+  if ( !removed.empty() ) reindex(first);
+  return removed;
+}
+
+
+
+int
+SlRenderQueue::find(const SlSprite* sprite, unsigned int destination) const
+{
+  auto iter = index_.find( Key(sprite, destination) );
+  if ( iter == index_.end() ) return -1;
+  return iter->second.position;
+}
+
+
+
+void
+SlRenderQueue::insert(unsigned int position, SlRenderItem* item)
+{
+  if ( position > items_.size() ) position = items_.size();
+  items_.insert( items_.begin() + position, item );
+  addToIndex(item, position);
+  reindex(position);
+  grid_.touch( item->sprite_.get(), item->destination_ );
+}
+
+
+
+SlRenderQueue::Key
+SlRenderQueue::keyOf(const SlRenderItem* item)
+{
+  return Key( item->sprite_.get(), item->destination_ );
+}
+
+
+
+bool
+SlRenderQueue::move(unsigned int toMove, unsigned int target, int beforeOrAfter)
+{
+  if ( toMove == target ) return false;
+  auto iter1 = items_.begin() + toMove;
+  auto iter2 = items_.begin() + target;
+
+  /* Cheat sheet
+    std::rotate( iter2, iter1, iter1+1 );   // insert before, iter1 > iter 2
+    std::rotate( iter2+1, iter1, iter1+1 );  // insert after, iter1 > iter 2
+    std::rotate( iter1, iter1+1, iter2 );   // insert before, iter1 < iter 2
+    std::rotate( iter1, iter1+1, iter2+1 );  // insert after, iter1 < iter 2
+  */
+  if ( iter1 > iter2 ) {
+    std::rotate( iter2 + beforeOrAfter, iter1, iter1+1 );
+    reindex( target + std::min(beforeOrAfter, 0) );
+  }
+  else {
+    std::rotate( iter1, iter1+1, iter2 + beforeOrAfter );
+    reindex(toMove);
+  }
+  return true;
+}
+
+
+
+int
+SlRenderQueue::picked() const
+{
+  if ( picked_.first == nullptr ) return -1;
+  return find( picked_.first, picked_.second );
+}
+
+
+
+void
+SlRenderQueue::push_back(SlRenderItem* item)
+{
+  items_.push_back(item);
+  addToIndex(item, items_.size() - 1);
+  grid_.touch( item->sprite_.get(), item->destination_ );
+}
+
+
+
+void
+SlRenderQueue::reindex(unsigned int position)
+{
+  //! Entries that pointed at or behind position only have items at or behind position, so they can be recomputed from there.
+  unsigned int unset = items_.size();
+  for ( unsigned int i = position ; i < items_.size() ; ++i ) {
+    Entry& entry = index_[ keyOf(items_[i]) ];
+    if ( entry.position >= position ) entry.position = unset;
+  }
+  for ( unsigned int i = position ; i < items_.size() ; ++i ) {
+    Entry& entry = index_[ keyOf(items_[i]) ];
+    if ( i < entry.position ) entry.position = i;
+  }
+}
+
+
+
+void
+SlRenderQueue::removeFromIndex(const SlRenderItem* item)
+{
+  auto iter = index_.find( keyOf(item) );
+  if ( iter == index_.end() ) return;
+  if ( --(iter->second.count) == 0 ) index_.erase(iter);
+}
+
+
+
+void
+SlRenderQueue::setPicked(int position)
+{
+  if ( position < 0 ) 
+    picked_ = Key(nullptr, 0);
+  else
+    picked_ = keyOf( items_.at(position) );
+}
+
+
+
+SlRenderItem*
+SlRenderQueue::replace(unsigned int position, SlRenderItem* item)
+{
+  SlRenderItem* old = items_.at(position);
+  removeFromIndex(old);
+  items_[position] = item;
+  addToIndex(item, position);
+  grid_.touch( old->sprite_.get(), old->destination_ );
+  grid_.touch( item->sprite_.get(), item->destination_ );
+  //! Another item with the old key may now be the first one.
+  auto iter = index_.find( keyOf(old) );
+  if ( iter != index_.end() && iter->second.position == position ) reindex(position);
+  return old;
+}
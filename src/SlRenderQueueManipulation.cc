@@ -15,12 +15,13 @@
 
 #include "SlSpriteManager.h"
 #include "SlRenderItem.h"
+#include "SlRenderQueue.h"
 #include "SlValueParser.h"
 
 #include "SlRenderQueueManipulation.h"
 
 
-SlRenderQueueManipulation::SlRenderQueueManipulation(SlSpriteManager* smngr, SlValueParser* valPars, std::vector<SlRenderItem*>* renderQueue)
+SlRenderQueueManipulation::SlRenderQueueManipulation(SlSpriteManager* smngr, SlValueParser* valPars, SlRenderQueue* renderQueue)
   : SlManipulation(smngr, valPars)
 {
   renderQueue_ = renderQueue;
@@ -54,6 +55,19 @@ SlRenderQueueManipulation::createRenderItem(const std::string& name, unsigned in
 
 
 
+int
+SlRenderQueueManipulation::findInRenderQueue(const std::string& name, unsigned int destination)
+{
+  try {
+    return renderQueue_->find( smngr_->findSprite(name).get(), destination );
+  }
+  catch (const std::invalid_argument& expt) {
+    return -1;
+  }
+}
+
+
+
 void 
 SlRenderQueueManipulation::manipulate(const std::string& name, unsigned int destination, const std::vector<std::string>& parameters)
 {
@@ -67,31 +81,18 @@ SlRenderQueueManipulation::manipulate(const std::string& name, unsigned int dest
 void
 SlRenderQueueManipulation::moveInRenderQueue(const std::string& toMoveName, const std::string& targetName, unsigned int destToMove, unsigned int targetDest, int beforeOrAfter)
 {
-  
-  auto iter1 = std::find_if( renderQueue_->begin(), renderQueue_->end(),
-			     [toMoveName, destToMove](const SlRenderItem* item) -> bool { return ( (item)->sprite_->name() == toMoveName && (item)->destination_ == destToMove ); } );
-  if ( iter1 == renderQueue_->end() ) 
+  int toMove = findInRenderQueue(toMoveName, destToMove);
+  if ( toMove < 0 ) 
     throw std::invalid_argument( "[SlManager::moveInRenderQueueAfter] Couldn't find item to move " + toMoveName );
 
-  auto iter2 = std::find_if( renderQueue_->begin(), renderQueue_->end(),
-			     [targetName, targetDest](const SlRenderItem* item) -> bool { return ( (item)->sprite_->name() == targetName && (item)->destination_ == targetDest ); } );
-  if ( iter2 == renderQueue_->end() )
+  int target = findInRenderQueue(targetName, targetDest);
+  if ( target < 0 )
     throw std::invalid_argument( "[SlManager::moveInRenderQueueAfter] Couldn't find item to move after " + targetName );
 
-
-  /* Cheat sheet
-    std::rotate( iter2, iter1, iter1+1 );   // insert before, iter1 > iter 2
-    std::rotate( iter2+1, iter1, iter1+1 );  // insert after, iter1 > iter 2
-    std::rotate( iter1, iter1+1, iter2 );   // insert before, iter1 < iter 2
-    std::rotate( iter1, iter1+1, iter2+1 );  // insert after, iter1 < iter 2
-  */
-
-  if ( iter1 == iter2 ) 
+  if ( toMove == target ) 
     return ;
-  else if ( iter1 > iter2 )
-    std::rotate( iter2 + beforeOrAfter, iter1, iter1+1 ); 
-  else if ( iter1 < iter2 ) 
-    std::rotate( iter1, iter1+1, iter2 + beforeOrAfter );
+  renderQueue_->at(toMove)->markDirty();
+  renderQueue_->move(toMove, target, beforeOrAfter);
 }
 
 
@@ -100,7 +101,7 @@ SlRenderQueueManipulation::moveInRenderQueue(const std::string& toMoveName, cons
 
 /*! \class SlRMappend implementation
  */
-SlRMappend::SlRMappend(SlSpriteManager* smngr, SlValueParser* valPars, std::vector<SlRenderItem*>* renderQueue)
+SlRMappend::SlRMappend(SlSpriteManager* smngr, SlValueParser* valPars, SlRenderQueue* renderQueue)
   : SlRenderQueueManipulation( smngr, valPars, renderQueue )
 {
   name_ = "append";
@@ -121,6 +122,7 @@ SlRMappend::manipulate(const std::string& name, unsigned int destination, const
   toAdd = createRenderItem(name, destination);
   if ( toAdd ) {
     renderQueue_->push_back(toAdd);
+    toAdd->markDirty();
   }
 }
 
@@ -128,7 +130,7 @@ SlRMappend::manipulate(const std::string& name, unsigned int destination, const
 
 /*! \class SlRMinsertAfter implementation
  */
-SlRMinsertAfter::SlRMinsertAfter(SlSpriteManager* smngr, SlValueParser* valPars, std::vector<SlRenderItem*>* renderQueue)
+SlRMinsertAfter::SlRMinsertAfter(SlSpriteManager* smngr, SlValueParser* valPars, SlRenderQueue* renderQueue)
   : SlRenderQueueManipulation( smngr, valPars, renderQueue )
 {
   name_ = "insertAfter";
@@ -150,23 +152,20 @@ SlRMinsertAfter::manipulate(const std::string& name, unsigned int destination, c
   if ( !toAdd ) 
     throw std::runtime_error("[SlRMinsertAfter::manipulate] Couldn't create render item for " + name);
 
-  std::vector<SlRenderItem*>::iterator iter;
-  for ( iter = renderQueue_->begin(); iter != renderQueue_->end() ; ++iter) {
-    if ( ( (*iter)->sprite_->name() ==  afterThis ) && ( (*iter)->destination_ == destAfterThis ) ) {
-      renderQueue_->insert( (++iter), toAdd );
-      break;
-    }
-  }
-
-  if ( iter == renderQueue_->end() )
+  int position = findInRenderQueue(afterThis, destAfterThis);
+  if ( position < 0 ) {
+    delete toAdd;
     throw std::runtime_error("[SlRMinsertAfter::manipulate] Couldn't find RenderItem " + afterThis + " to insert after.");
+  }
+  renderQueue_->insert( position + 1, toAdd );
+  toAdd->markDirty();
 }
 
 
 
 /*! \class SlRMinsertBefore implementation
  */
-SlRMinsertBefore::SlRMinsertBefore(SlSpriteManager* smngr, SlValueParser* valPars, std::vector<SlRenderItem*>* renderQueue)
+SlRMinsertBefore::SlRMinsertBefore(SlSpriteManager* smngr, SlValueParser* valPars, SlRenderQueue* renderQueue)
   : SlRenderQueueManipulation( smngr, valPars, renderQueue )
 {
   name_ = "insertBefore";
@@ -188,24 +187,20 @@ SlRMinsertBefore::manipulate(const std::string& name, unsigned int destination,
   if ( !toAdd ) 
     throw std::runtime_error("[SlRMinsertBefore::manipulate] Couldn't create render item for " + name);
 
-  std::vector<SlRenderItem*>::iterator iter;
-  for ( iter = renderQueue_->begin(); iter != renderQueue_->end() ; ++iter) {
-    if ( ( (*iter)->sprite_->name() ==  beforeThis ) && ( (*iter)->destination_ == destBeforeThis ) ) {
-      renderQueue_->insert( (iter), toAdd );
-      break;
-    }
-  }
-
-  if ( iter == renderQueue_->end() )
+  int position = findInRenderQueue(beforeThis, destBeforeThis);
+  if ( position < 0 ) {
+    delete toAdd;
     throw std::runtime_error("[SlRMinsertBefore::manipulate] Couldn't find RenderItem " + beforeThis + " to insert before.");
-
+  }
+  renderQueue_->insert( position, toAdd );
+  toAdd->markDirty();
 }
 
 
 
 /*! \class SlRMmoveBefore implementation
  */
-SlRMmoveBefore::SlRMmoveBefore(SlSpriteManager* smngr, SlValueParser* valPars, std::vector<SlRenderItem*>* renderQueue)
+SlRMmoveBefore::SlRMmoveBefore(SlSpriteManager* smngr, SlValueParser* valPars, SlRenderQueue* renderQueue)
   : SlRenderQueueManipulation( smngr, valPars, renderQueue )
 {
   name_ = "moveBefore";
@@ -228,7 +223,7 @@ SlRMmoveBefore::manipulate(const std::string& name, unsigned int destination, co
 
 /*! \class SlRMmoveAfter implementation
  */
-SlRMmoveAfter::SlRMmoveAfter(SlSpriteManager* smngr, SlValueParser* valPars, std::vector<SlRenderItem*>* renderQueue)
+SlRMmoveAfter::SlRMmoveAfter(SlSpriteManager* smngr, SlValueParser* valPars, SlRenderQueue* renderQueue)
   : SlRenderQueueManipulation( smngr, valPars, renderQueue )
 {
   name_ = "moveAfter";
@@ -251,7 +246,7 @@ SlRMmoveAfter::manipulate(const std::string& name, unsigned int destination, con
 
 /*! \class SlRMswapIn implementation
  */
-SlRMswapIn::SlRMswapIn(SlSpriteManager* smngr, SlValueParser* valPars, std::vector<SlRenderItem*>* renderQueue)
+SlRMswapIn::SlRMswapIn(SlSpriteManager* smngr, SlValueParser* valPars, SlRenderQueue* renderQueue)
   : SlRenderQueueManipulation( smngr, valPars, renderQueue )
 {
   name_ = "swap";
@@ -273,24 +268,22 @@ SlRMswapIn::manipulate(const std::string& name, unsigned int destination, const
   if ( !toAdd ) 
     throw std::runtime_error("[SlRMswapIn::manipulate] Couldn't create render item for " + name);
 
-  std::vector<SlRenderItem*>::iterator iter;
-  for ( iter = renderQueue_->begin(); iter != renderQueue_->end() ; ++iter) {
-    if ( ( (*iter)->sprite_->name() ==  toReplace ) && ( (*iter)->destination_ == destToReplace ) ) {
-      delete (*iter);
-      *iter = toAdd;
-      break;
-    }
-  }
-
-  if ( iter == renderQueue_->end() )
+  int position = findInRenderQueue(toReplace, destToReplace);
+  if ( position < 0 ) {
+    delete toAdd;
     throw std::runtime_error("[SlRMswapIn::manipulate] Couldn't find RenderItem " + toReplace + " to swap with.");
+  }
+  SlRenderItem* old = renderQueue_->replace(position, toAdd);
+  old->markDirty();
+  delete old;
+  toAdd->markDirty();
 }
 
 
 
 /*! \class SlRMtoggleOnOff implementation
  */
-SlRMtoggleOnOff::SlRMtoggleOnOff(SlSpriteManager* smngr, SlValueParser* valPars, std::vector<SlRenderItem*>* renderQueue)
+SlRMtoggleOnOff::SlRMtoggleOnOff(SlSpriteManager* smngr, SlValueParser* valPars, SlRenderQueue* renderQueue)
   : SlRenderQueueManipulation( smngr, valPars, renderQueue )
 {
   name_ = "toggleOnOff";
@@ -314,25 +307,23 @@ SlRMtoggleOnOff::manipulate(const std::string& name, unsigned int destination, c
  if ( (onOrOff < -1) || (onOrOff > 1) )
    throw std::invalid_argument( "[SlRMtoggleOnOff::manipulate] Invalid toggle option " + parameters.at(0) );
 
- std::vector<SlRenderItem*>::iterator iter;
-  for ( iter = renderQueue_->begin(); iter != renderQueue_->end() ; ++iter) {
-    if ( ( (*iter)->sprite_->name() ==  name ) && ( (*iter)->destination_ == destination ) ) {
-      switch (onOrOff){
-      case -1:
-	(*iter)->renderMe_ = !((*iter)->renderMe_) ;
-	return;
-      case 0:	
-	(*iter)->renderMe_ = false ;
-	return;
-      case 1:
-	(*iter)->renderMe_ = true ;
-	return;
-      }
-    }
-  }
-
-  if ( iter == renderQueue_->end() ) 
+ int position = findInRenderQueue(name, destination);
+ if ( position < 0 ) 
     throw std::invalid_argument( "[SlRMtoggleOnOff::manipulate] Couldn't find sprite to toggle: " + name );
+
+  SlRenderItem* item = renderQueue_->at(position);
+  item->markDirty();
+  switch (onOrOff){
+  case -1:
+    item->renderMe_ = !(item->renderMe_) ;
+    return;
+  case 0:	
+    item->renderMe_ = false ;
+    return;
+  case 1:
+    item->renderMe_ = true ;
+    return;
+  }
 }
 
 
@@ -340,7 +331,7 @@ SlRMtoggleOnOff::manipulate(const std::string& name, unsigned int destination, c
 
 /*! \class SlRMswapAt implementation
  */
-SlRMswapAt::SlRMswapAt(SlSpriteManager* smngr, SlValueParser* valPars, std::vector<SlRenderItem*>* renderQueue)
+SlRMswapAt::SlRMswapAt(SlSpriteManager* smngr, SlValueParser* valPars, SlRenderQueue* renderQueue)
   : SlRenderQueueManipulation( smngr, valPars, renderQueue )
 {
   name_ = "swapAt";
@@ -363,10 +354,10 @@ SlRMswapAt::manipulate(const std::string& name, unsigned int destination, const
   if ( !toAdd ) 
     throw std::runtime_error("[SlRMswapAt::manipulate] Couldn't create render item for " + name);
 
-  std::vector<SlRenderItem*>::iterator iter = renderQueue_->begin() + position;
-  delete (*iter);
-  renderQueue_->erase( iter );
-  renderQueue_->insert( iter, toAdd );
+  SlRenderItem* old = renderQueue_->replace(position, toAdd);
+  old->markDirty();
+  delete old;
+  toAdd->markDirty();
 
 }
 
@@ -374,7 +365,7 @@ SlRMswapAt::manipulate(const std::string& name, unsigned int destination, const
 
 /*! \class SlRMactivate implementation
  */
-SlRMactivate::SlRMactivate(SlSpriteManager* smngr, SlValueParser* valPars, std::vector<SlRenderItem*>* renderQueue)
+SlRMactivate::SlRMactivate(SlSpriteManager* smngr, SlValueParser* valPars, SlRenderQueue* renderQueue)
   : SlRenderQueueManipulation( smngr, valPars, renderQueue )
 {
   name_ = "activate";
@@ -385,23 +376,18 @@ SlRMactivate::SlRMactivate(SlSpriteManager* smngr, SlValueParser* valPars, std::
 void
 SlRMactivate::manipulate(const std::string& name, unsigned int destination, const std::vector<std::string>& parameters)
 {
-  auto iter = renderQueue_->begin();
-  for ( ; iter != renderQueue_->end() ; ++iter) {
-    if ( ( (*iter)->sprite_->name() ==  name ) && ( (*iter)->destination_ == destination ) ) {
-      (*iter)->isActive = true;
-      return;
-    }
-  }
-
-  if ( iter == renderQueue_->end() )
+  int position = findInRenderQueue(name, destination);
+  if ( position < 0 )
     throw std::runtime_error( "[SlRMactivate::manipulate] Error: Couldn't find SlRenderItem for " + name ) ;
+
+  renderQueue_->at(position)->isActive = true;
 }
 
 
 
 /*! \class SlRMactivateIfInside implementation
  */
-SlRMactivateIfInside::SlRMactivateIfInside(SlSpriteManager* smngr, SlValueParser* valPars, std::vector<SlRenderItem*>* renderQueue)
+SlRMactivateIfInside::SlRMactivateIfInside(SlSpriteManager* smngr, SlValueParser* valPars, SlRenderQueue* renderQueue)
   : SlRenderQueueManipulation( smngr, valPars, renderQueue )
 {
   name_ = "activateIfInside";
@@ -415,27 +401,40 @@ SlRMactivateIfInside::manipulate(const std::string& name, unsigned int destinati
   if ( parameters.size() < 2 )
     throw std::invalid_argument("[SlRMactivateIfInside::manipulate] Error: Need 2 coordinates to move object " + name + "; found " + std::to_string(parameters.size()) );
 
-  auto iter = renderQueue_->begin();
-  for ( ; iter != renderQueue_->end() ; ++iter) {
-    if ( ( (*iter)->sprite_->name() ==  name ) && ( (*iter)->destination_ == destination ) ) {
-      break;
-    }
-  }
-
-  if ( iter == renderQueue_->end() )
+  int position = findInRenderQueue(name, destination);
+  if ( position < 0 )
     throw std::runtime_error( "[SlRMactivateIfInside::manipulate] Error: Couldn't find SlRenderItem for " + name ) ;
 
+  SlRenderItem* item = renderQueue_->at(position);
   int coord[2];
   valParser->stringsToNumbers<int>( parameters, coord, 2 );
-  if ( (*iter)->is_inside( coord[0], coord[1] )) 
-    (*iter)->isActive = true;
+  if ( item->is_inside( coord[0], coord[1] )) 
+    item->isActive = true;
+}
+
+
+
+void
+SlRMactivateIfInside::apply(const std::string& name, unsigned int destination, const SlArguments& arguments)
+{
+  int coord[2];
+  if ( !coordinates(arguments, coord, 2) )
+    throw std::invalid_argument("[SlRMactivateIfInside::apply] Error: Need 2 coordinates to activate object " + name );
+
+  int position = findInRenderQueue(name, destination);
+  if ( position < 0 )
+    throw std::runtime_error( "[SlRMactivateIfInside::apply] Error: Couldn't find SlRenderItem for " + name ) ;
+
+  SlRenderItem* item = renderQueue_->at(position);
+  if ( item->is_inside( coord[0], coord[1] )) 
+    item->isActive = true;
 }
 
 
 
 /*! \class SlRMdeactivate implementation
  */
-SlRMdeactivate::SlRMdeactivate(SlSpriteManager* smngr, SlValueParser* valPars, std::vector<SlRenderItem*>* renderQueue)
+SlRMdeactivate::SlRMdeactivate(SlSpriteManager* smngr, SlValueParser* valPars, SlRenderQueue* renderQueue)
   : SlRenderQueueManipulation( smngr, valPars, renderQueue )
 {
   name_ = "deactivate";
@@ -446,16 +445,11 @@ SlRMdeactivate::SlRMdeactivate(SlSpriteManager* smngr, SlValueParser* valPars, s
 void
 SlRMdeactivate::manipulate(const std::string& name, unsigned int destination, const std::vector<std::string>& parameters)
 {
-  auto iter = renderQueue_->begin();
-  for ( ; iter != renderQueue_->end() ; ++iter) {
-    if ( ( (*iter)->sprite_->name() ==  name ) && ( (*iter)->destination_ == destination ) ) {
-      (*iter)->isActive = false;
-      return;
-    }
-  }
-
-  if ( iter == renderQueue_->end() )
+  int position = findInRenderQueue(name, destination);
+  if ( position < 0 )
     throw std::runtime_error( "[SlRMdeactivate::manipulate] Error: Couldn't find SlRenderItem for " + name ) ;
+
+  renderQueue_->at(position)->isActive = false;
 }
 
 
@@ -463,7 +457,7 @@ SlRMdeactivate::manipulate(const std::string& name, unsigned int destination, co
 
 /*! \class SlRMdeactivateIfInside implementation
  */
-SlRMdeactivateIfInside::SlRMdeactivateIfInside(SlSpriteManager* smngr, SlValueParser* valPars, std::vector<SlRenderItem*>* renderQueue)
+SlRMdeactivateIfInside::SlRMdeactivateIfInside(SlSpriteManager* smngr, SlValueParser* valPars, SlRenderQueue* renderQueue)
   : SlRenderQueueManipulation( smngr, valPars, renderQueue )
 {
   name_ = "deactivateIfInside";
@@ -477,20 +471,34 @@ SlRMdeactivateIfInside::manipulate(const std::string& name, unsigned int destina
   if ( parameters.size() < 2 )
    throw std::invalid_argument("[SlRMdeactivateIfInside::manipulate] Error: Need 2 coordinates to move object " + name + "; found " + std::to_string(parameters.size()) );
     
-  auto iter = renderQueue_->begin();
-  for ( ; iter != renderQueue_->end() ; ++iter) {
-    if ( ( (*iter)->sprite_->name() ==  name ) && ( (*iter)->destination_ == destination ) ) {
-      break;
-    }
-  }
-
-  if ( iter == renderQueue_->end() )
+  int position = findInRenderQueue(name, destination);
+  if ( position < 0 )
     throw std::runtime_error( "[SlRMactivateIfInside::manipulate] Error: Couldn't find SlRenderItem for " + name ) ;
 
+  SlRenderItem* item = renderQueue_->at(position);
   int coord[2];
   valParser->stringsToNumbers<int>( parameters, coord, 2 );
-  if ( (*iter)->is_inside( coord[0], coord[1] ) ) {
-    (*iter)->isActive = false;
+  if ( item->is_inside( coord[0], coord[1] ) ) {
+    item->isActive = false;
+  }
+}
+
+
+
+void
+SlRMdeactivateIfInside::apply(const std::string& name, unsigned int destination, const SlArguments& arguments)
+{
+  int coord[2];
+  if ( !coordinates(arguments, coord, 2) )
+    throw std::invalid_argument("[SlRMdeactivateIfInside::apply] Error: Need 2 coordinates to deactivate object " + name );
+
+  int position = findInRenderQueue(name, destination);
+  if ( position < 0 )
+    throw std::runtime_error( "[SlRMdeactivateIfInside::apply] Error: Couldn't find SlRenderItem for " + name ) ;
+
+  SlRenderItem* item = renderQueue_->at(position);
+  if ( item->is_inside( coord[0], coord[1] ) ) {
+    item->isActive = false;
   }
 }
 
@@ -498,7 +506,7 @@ SlRMdeactivateIfInside::manipulate(const std::string& name, unsigned int destina
 
 /*! \class SlRMmoveBy implementation
  */
-SlRMmoveBy::SlRMmoveBy(SlSpriteManager* smngr, SlValueParser* valPars, std::vector<SlRenderItem*>* renderQueue)
+SlRMmoveBy::SlRMmoveBy(SlSpriteManager* smngr, SlValueParser* valPars, SlRenderQueue* renderQueue)
   : SlRenderQueueManipulation( smngr, valPars, renderQueue )
 {
   name_ = "moveBy";
@@ -512,26 +520,37 @@ SlRMmoveBy::manipulate(const std::string& name, unsigned int destination, const
   if (parameters.size() != 4 )
     throw std::invalid_argument("[SlRMmoveBy::manipulate] Error: Need 4 parameters (x,y,dx,dy) to move object " + name + "; found " + std::to_string(parameters.size()) );
 
-  auto iter = renderQueue_->begin();
-  for ( ; iter != renderQueue_->end() ; ++iter) {
-    if ( ( (*iter)->sprite_->name() ==  name ) && ( (*iter)->destination_ == destination ) ) {
-      break;
-    }
-  }
-
-  if ( iter == renderQueue_->end() )
+  int position = findInRenderQueue(name, destination);
+  if ( position < 0 )
     throw std::runtime_error( "[SlRMmoveBy::manipulate] Error: Couldn't find SlRenderItem for " + name ) ;
 
+  SlRenderItem* item = renderQueue_->at(position);
   int coord[4];
   valParser->stringsToNumbers<int>( parameters, coord, 4 );
-  (*iter)->sprite_->moveDestinationOriginBy(coord[2], coord[3], destination);
+  item->sprite_->moveDestinationOriginBy(coord[2], coord[3], destination);
+}
+
+
+
+void
+SlRMmoveBy::apply(const std::string& name, unsigned int destination, const SlArguments& arguments)
+{
+  int coord[4];
+  if ( !coordinates(arguments, coord, 4) )
+    throw std::invalid_argument("[SlRMmoveBy::apply] Error: Need 4 parameters (x,y,dx,dy) to move object " + name );
+
+  int position = findInRenderQueue(name, destination);
+  if ( position < 0 )
+    throw std::runtime_error( "[SlRMmoveBy::apply] Error: Couldn't find SlRenderItem for " + name ) ;
+
+  renderQueue_->at(position)->sprite_->moveDestinationOriginBy(coord[2], coord[3], destination);
 }
 
 
 
 /*! \class SlRMmoveActiveBy implementation
  */
-SlRMmoveActiveBy::SlRMmoveActiveBy(SlSpriteManager* smngr, SlValueParser* valPars, std::vector<SlRenderItem*>* renderQueue)
+SlRMmoveActiveBy::SlRMmoveActiveBy(SlSpriteManager* smngr, SlValueParser* valPars, SlRenderQueue* renderQueue)
   : SlRenderQueueManipulation( smngr, valPars, renderQueue )
 {
   name_ = "moveActiveBy";
@@ -545,18 +564,135 @@ SlRMmoveActiveBy::manipulate(const std::string& name, unsigned int destination,
   if (parameters.size() != 4 )
     throw std::invalid_argument("[SlRMmoveActiveBy::manipulate] Error: Need 4 parameters (x,y,dx,dy) to move object " + name + "; found " + std::to_string(parameters.size()) );
 
-  auto iter = renderQueue_->begin();
-  for ( ; iter != renderQueue_->end() ; ++iter) {
-    if ( ( (*iter)->sprite_->name() ==  name ) && ( (*iter)->destination_ == destination ) ) {
-      break;
-    }
-  }
-
-  if ( iter == renderQueue_->end() )
+  int position = findInRenderQueue(name, destination);
+  if ( position < 0 )
     throw std::runtime_error( "[SlRMmoveActiveBy::manipulate] Error: Couldn't find SlRenderItem for " + name ) ;
 
-  if ( !(*iter)->isActive ) return;
+  SlRenderItem* item = renderQueue_->at(position);
+  if ( !item->isActive ) return;
   int coord[4];
   valParser->stringsToNumbers<int>( parameters, coord, 4 );
-   (*iter)->sprite_->moveDestinationOriginBy(coord[2], coord[3], destination);
+   item->sprite_->moveDestinationOriginBy(coord[2], coord[3], destination);
+}
+
+
+
+void
+SlRMmoveActiveBy::apply(const std::string& name, unsigned int destination, const SlArguments& arguments)
+{
+  int position = findInRenderQueue(name, destination);
+  if ( position < 0 )
+    throw std::runtime_error( "[SlRMmoveActiveBy::apply] Error: Couldn't find SlRenderItem for " + name ) ;
+
+  SlRenderItem* item = renderQueue_->at(position);
+  if ( !item->isActive ) return;
+  int coord[4];
+  if ( !coordinates(arguments, coord, 4) )
+    throw std::invalid_argument("[SlRMmoveActiveBy::apply] Error: Need 4 parameters (x,y,dx,dy) to move object " + name );
+  item->sprite_->moveDestinationOriginBy(coord[2], coord[3], destination);
+}
+
+
+
+/*! \class SlRMpick implementation
+ */
+SlRMpick::SlRMpick(SlSpriteManager* smngr, SlValueParser* valPars, SlRenderQueue* renderQueue)
+  : SlRenderQueueManipulation( smngr, valPars, renderQueue )
+{
+  name_ = "pick";
+}
+
+
+
+void
+SlRMpick::manipulate(const std::string& name, unsigned int destination, const std::vector<std::string>& parameters)
+{
+  if ( parameters.size() < 2 )
+    throw std::invalid_argument("[SlRMpick::manipulate] Error: Need 2 coordinates to pick an object; found " + std::to_string(parameters.size()) );
+  int coord[2];
+  valParser->stringsToNumbers<int>( parameters, coord, 2 );
+  pick( coord[0], coord[1] );
+}
+
+
+
+void
+SlRMpick::apply(const std::string& name, unsigned int destination, const SlArguments& arguments)
+{
+  int coord[2];
+  if ( !coordinates(arguments, coord, 2) )
+    throw std::invalid_argument("[SlRMpick::apply] Error: Need 2 coordinates to pick an object" );
+  pick( coord[0], coord[1] );
+}
+
+
+
+void
+SlRMpick::pick(int x, int y)
+{
+  int position = renderQueue_->pick(x, y);
+  renderQueue_->setPicked(position);
+  if ( position >= 0 )
+    renderQueue_->at(position)->isActive = true;
+}
+
+
+
+/*! \class SlRMmovePickedBy implementation
+ */
+SlRMmovePickedBy::SlRMmovePickedBy(SlSpriteManager* smngr, SlValueParser* valPars, SlRenderQueue* renderQueue)
+  : SlRenderQueueManipulation( smngr, valPars, renderQueue )
+{
+  name_ = "movePickedBy";
+}
+
+
+
+void
+SlRMmovePickedBy::manipulate(const std::string& name, unsigned int destination, const std::vector<std::string>& parameters)
+{
+  if (parameters.size() != 4 )
+    throw std::invalid_argument("[SlRMmovePickedBy::manipulate] Error: Need 4 parameters (x,y,dx,dy) to move the picked object; found " + std::to_string(parameters.size()) );
+
+  int position = renderQueue_->picked();
+  if ( position < 0 ) return;
+  SlRenderItem* item = renderQueue_->at(position);
+  int coord[4];
+  valParser->stringsToNumbers<int>( parameters, coord, 4 );
+  item->sprite_->moveDestinationOriginBy(coord[2], coord[3], item->destination_);
+}
+
+
+
+void
+SlRMmovePickedBy::apply(const std::string& name, unsigned int destination, const SlArguments& arguments)
+{
+  int position = renderQueue_->picked();
+  if ( position < 0 ) return;
+  SlRenderItem* item = renderQueue_->at(position);
+  int coord[4];
+  if ( !coordinates(arguments, coord, 4) )
+    throw std::invalid_argument("[SlRMmovePickedBy::apply] Error: Need 4 parameters (x,y,dx,dy) to move the picked object" );
+  item->sprite_->moveDestinationOriginBy(coord[2], coord[3], item->destination_);
+}
+
+
+
+/*! \class SlRMdrop implementation
+ */
+SlRMdrop::SlRMdrop(SlSpriteManager* smngr, SlValueParser* valPars, SlRenderQueue* renderQueue)
+  : SlRenderQueueManipulation( smngr, valPars, renderQueue )
+{
+  name_ = "drop";
+}
+
+
+
+void
+SlRMdrop::manipulate(const std::string& name, unsigned int destination, const std::vector<std::string>& parameters)
+{
+  int position = renderQueue_->picked();
+  if ( position >= 0 )
+    renderQueue_->at(position)->isActive = false;
+  renderQueue_->setPicked(-1);
 }
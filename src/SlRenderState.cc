@@ -0,0 +1,140 @@
+// part of SDL2lazy
+// author: Ulrike Hager
+
+/*! \file SlRenderState.cc
+
+  SlRenderState implementation
+*/
+
+#include "SlSprite.h"
+#include "SlRenderState.h"
+
+
+
+SlRenderState::SlRenderState()
+{
+}
+
+
+
+SlRenderState::~SlRenderState()
+{
+}
+
+
+
+void
+SlRenderState::apply(SDL_Texture* texture, const SlRenderSettings& settings)
+{
+  if ( (settings.renderOptions & SL_RENDER_COLORMOD) == SL_RENDER_COLORMOD )
+    setColorMod( texture, settings.color[0], settings.color[1], settings.color[2] );
+  else
+    setColorMod( texture, 0xFF, 0xFF, 0xFF );
+
+  if ( (settings.renderOptions & SL_RENDER_ALPHAMOD) == SL_RENDER_ALPHAMOD ) {
+    setBlendMode( texture, SDL_BLENDMODE_BLEND );
+    setAlphaMod( texture, settings.color[3] );
+  }
+  else {
+    setBlendMode( texture, defaultBlendMode(texture) );
+    setAlphaMod( texture, 0xFF );
+  }
+}
+
+
+
+void
+SlRenderState::beginFrame()
+{
+  issued_ = 0;
+  saved_ = 0;
+}
+
+
+
+void
+SlRenderState::count(bool isIssued)
+{
+  if ( isIssued ) {
+    ++issued_;
+    ++totalIssued_;
+  }
+  else {
+    ++saved_;
+    ++totalSaved_;
+  }
+}
+
+
+
+SDL_BlendMode
+SlRenderState::defaultBlendMode(SDL_Texture* texture)
+{
+  return state(texture).defaultBlendMode;
+}
+
+
+
+void
+SlRenderState::forget(SDL_Texture* texture)
+{
+  states_.erase(texture);
+}
+
+
+
+void
+SlRenderState::setAlphaMod(SDL_Texture* texture, uint8_t alpha)
+{
+  TextureState& current = state(texture);
+  bool isChanged = ( current.alpha != alpha );
+  if ( isChanged ) {
+    SDL_SetTextureAlphaMod( texture, alpha );
+    current.alpha = alpha;
+  }
+  count(isChanged);
+}
+
+
+
+void
+SlRenderState::setBlendMode(SDL_Texture* texture, SDL_BlendMode blendMode)
+{
+  TextureState& current = state(texture);
+  bool isChanged = ( current.blendMode != blendMode );
+  if ( isChanged ) {
+    SDL_SetTextureBlendMode( texture, blendMode );
+    current.blendMode = blendMode;
+  }
+  count(isChanged);
+}
+
+
+
+void
+SlRenderState::setColorMod(SDL_Texture* texture, uint8_t red, uint8_t green, uint8_t blue)
+{
+  TextureState& current = state(texture);
+  bool isChanged = ( current.color[0] != red || current.color[1] != green || current.color[2] != blue );
+  if ( isChanged ) {
+    SDL_SetTextureColorMod( texture, red, green, blue );
+    current.color[0] = red;
+    current.color[1] = green;
+    current.color[2] = blue;
+  }
+  count(isChanged);
+}
+
+
+
+SlRenderState::TextureState&
+SlRenderState::state(SDL_Texture* texture)
+{
+  auto iter = states_.find(texture);
+  if ( iter != states_.end() ) return iter->second;
+
+  TextureState& added = states_[texture];
+  SDL_GetTextureBlendMode( texture, &added.defaultBlendMode );
+  added.blendMode = added.defaultBlendMode;
+  return added;
+}
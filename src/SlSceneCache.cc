@@ -0,0 +1,214 @@
+// part of SDL2lazy
+// author: Ulrike Hager
+
+/*! \file SlSceneCache.cc
+
+  SlSceneCache implementation
+*/
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include <sys/stat.h>
+
+#include "SlSceneCache.h"
+
+
+namespace {
+  //! "SLSC" read as a little-endian word, files from machines with the other byte order don't match.
+  const uint32_t SL_SCENE_MAGIC = 0x43534C53;
+  //! Number of words in the header.
+  const std::size_t SL_SCENE_HEADER = 11;
+}
+
+
+
+bool
+SlSceneCache::add(SlSceneOp op, std::initializer_list<std::string_view> strings, std::initializer_list<int> numbers, const std::vector<std::string>& list)
+{
+  if ( strings.size() > 0xFF || numbers.size() > 0xFF || list.size() > 0xFF ) {
+#ifdef DEBUG
+    std::cerr << "[SlSceneCache::add] Error: record too long, the scene won't be cached." << std::endl;
+#endif
+    isComplete_ = false;
+    return false;
+  }
+  records_.push_back( op | ( strings.size() << 8 ) | ( numbers.size() << 16 ) | ( list.size() << 24 ) );
+  for ( auto value: strings ) records_.push_back( intern(value) );
+  for ( auto value: numbers ) records_.push_back( static_cast<uint32_t>(value) );
+  for ( const auto& value: list ) records_.push_back( intern(value) );
+  return true;
+}
+
+
+
+void
+SlSceneCache::clear()
+{
+  strings_.clear();
+  stringIndex_.clear();
+  records_.clear();
+  cursor_ = 0;
+  isComplete_ = true;
+}
+
+
+
+bool
+SlSceneCache::fits(const Record& record)
+{
+  //! Strings and numbers per op, starting at SL_SCENE_TEXTURE_FILE; only manipulations and events have a list.
+  static const unsigned int counts[][2] = { {2,0}, {2,2}, {1,6}, {3,0}, {3,1}, {2,5}, {2,4}, {2,1}, {2,1}, {3,1}, {2,0} };
+  if ( record.op < SL_SCENE_TEXTURE_FILE || record.op > SL_SCENE_TEXTURE_ASYNC ) return false;
+  const unsigned int* expected = counts[ record.op - SL_SCENE_TEXTURE_FILE ];
+  if ( record.listCount > 0 && ( record.op < SL_SCENE_SPRITE_MANIPULATION || record.op > SL_SCENE_EVENT ) ) return false;
+  return ( record.stringCount == expected[0] && record.numberCount == expected[1] );
+}
+
+
+
+uint32_t
+SlSceneCache::intern(std::string_view value)
+{
+  auto result = stringIndex_.emplace( std::string(value), strings_.size() );
+  if ( result.second ) strings_.emplace_back(value);
+  return result.first->second;
+}
+
+
+
+std::vector<std::string>
+SlSceneCache::list(const Record& record) const
+{
+  std::vector<std::string> result;
+  result.reserve( record.listCount );
+  for ( unsigned int i = 0 ; i < record.listCount ; ++i )
+    result.push_back( strings_[ record.list[i] ] );
+  return result;
+}
+
+
+
+bool
+SlSceneCache::load(const std::string& filename, const std::string& source, int width, int height)
+{
+  uint64_t size, time;
+  if ( !stamp(source, size, time) ) return false;
+  std::ifstream input(filename, std::ifstream::in | std::ifstream::binary | std::ifstream::ate);
+  if ( !input.is_open() ) return false;
+  std::streamoff bytes = input.tellg();
+  if ( bytes < static_cast<std::streamoff>( SL_SCENE_HEADER * sizeof(uint32_t) ) || bytes % sizeof(uint32_t) != 0 ) return false;
+  std::vector<uint32_t> words( bytes / sizeof(uint32_t) );
+  input.seekg(0);
+  if ( !input.read( reinterpret_cast<char*>( words.data() ), bytes ) ) return false;
+
+  const uint32_t expected[] = { SL_SCENE_MAGIC, version, static_cast<uint32_t>(width), static_cast<uint32_t>(height),
+				static_cast<uint32_t>(size), static_cast<uint32_t>(size >> 32),
+				static_cast<uint32_t>(time), static_cast<uint32_t>(time >> 32) };
+  if ( std::memcmp( words.data(), expected, sizeof(expected) ) != 0 ) {
+#ifdef DEBUG
+    std::cout << "[SlSceneCache::read] " << filename << " is stale." << std::endl;
+#endif
+    return false;
+  }
+  uint32_t stringCount = words[8];
+  std::size_t stringWords = words[9];
+  std::size_t recordWords = words[10];
+  if ( SL_SCENE_HEADER + stringWords + recordWords != words.size() ) return false;
+
+  //! Everything is checked here so that replaying the records can't run past the end.
+  std::size_t position = SL_SCENE_HEADER;
+  std::size_t end = position + stringWords;
+  strings_.reserve(stringCount);
+  for ( uint32_t i = 0 ; i < stringCount ; ++i ) {
+    if ( position >= end ) return false;
+    std::size_t length = words[position++];
+    std::size_t lengthWords = ( length + sizeof(uint32_t) - 1 ) / sizeof(uint32_t);
+    if ( end - position < lengthWords ) return false;
+    strings_.emplace_back( reinterpret_cast<const char*>( words.data() + position ), length );
+    position += lengthWords;
+  }
+  if ( position != end ) return false;
+
+  records_.assign( words.begin() + end, words.end() );
+  Record record;
+  while ( next(record) ) {
+    if ( cursor_ > records_.size() || !fits(record) ) return false;
+    for ( unsigned int i = 0 ; i < record.stringCount ; ++i )
+      if ( record.strings[i] >= stringCount ) return false;
+    for ( unsigned int i = 0 ; i < record.listCount ; ++i )
+      if ( record.list[i] >= stringCount ) return false;
+  }
+  cursor_ = 0;
+  return true;
+}
+
+
+
+bool
+SlSceneCache::next(Record& record)
+{
+  if ( cursor_ >= records_.size() ) return false;
+  uint32_t header = records_[cursor_++];
+  record.op = static_cast<SlSceneOp>( header & 0xFF );
+  record.stringCount = ( header >> 8 ) & 0xFF;
+  record.numberCount = ( header >> 16 ) & 0xFF;
+  record.listCount = header >> 24;
+  record.strings = records_.data() + cursor_;
+  record.numbers = record.strings + record.stringCount;
+  record.list = record.numbers + record.numberCount;
+  cursor_ += record.stringCount + record.numberCount + record.listCount;
+  return true;
+}
+
+
+
+bool
+SlSceneCache::read(const std::string& filename, const std::string& source, int width, int height)
+{
+  clear();
+  if ( load(filename, source, width, height) ) return true;
+  //! Don't leave half a file behind, the cache may be used for recording next.
+  clear();
+  return false;
+}
+
+
+
+bool
+SlSceneCache::stamp(const std::string& source, uint64_t& size, uint64_t& time)
+{
+  struct stat info;
+  if ( stat( source.c_str(), &info ) != 0 ) return false;
+  size = info.st_size;
+  time = static_cast<uint64_t>( info.st_mtim.tv_sec ) * 1000000000 + info.st_mtim.tv_nsec;
+  return true;
+}
+
+
+
+bool
+SlSceneCache::write(const std::string& filename, const std::string& source, int width, int height) const
+{
+  uint64_t size, time;
+  if ( !isComplete_ || !stamp(source, size, time) ) return false;
+
+  std::vector<uint32_t> words = { SL_SCENE_MAGIC, version, static_cast<uint32_t>(width), static_cast<uint32_t>(height),
+				  static_cast<uint32_t>(size), static_cast<uint32_t>(size >> 32),
+				  static_cast<uint32_t>(time), static_cast<uint32_t>(time >> 32),
+				  static_cast<uint32_t>( strings_.size() ), 0, static_cast<uint32_t>( records_.size() ) };
+  for ( const auto& value: strings_ ) {
+    words.push_back( value.size() );
+    std::size_t position = words.size();
+    words.resize( position + ( value.size() + sizeof(uint32_t) - 1 ) / sizeof(uint32_t), 0 );
+    std::memcpy( words.data() + position, value.data(), value.size() );
+  }
+  words[9] = words.size() - SL_SCENE_HEADER;
+  words.insert( words.end(), records_.begin(), records_.end() );
+
+  std::ofstream output(filename, std::ofstream::out | std::ofstream::binary | std::ofstream::trunc);
+  if ( !output.is_open() ) return false;
+  output.write( reinterpret_cast<const char*>( words.data() ), words.size() * sizeof(uint32_t) );
+  return static_cast<bool>(output);
+}
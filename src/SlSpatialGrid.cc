@@ -0,0 +1,180 @@
+// part of SDL2lazy
+// author: Ulrike Hager
+
+/*! \file SlSpatialGrid.cc
+
+  SlSpatialGrid implementation
+*/
+
+#include <algorithm>
+
+#include "SlSprite.h"
+#include "SlRenderItem.h"
+#include "SlRenderQueue.h"
+#include "SlSpatialGrid.h"
+
+
+
+SlSpatialGrid::SlSpatialGrid()
+  : grid_(1)
+{
+}
+
+
+
+SlSpatialGrid::~SlSpatialGrid()
+{
+}
+
+
+
+void
+SlSpatialGrid::addToCells(const SlItemKey& key, const Entry& entry)
+{
+  for ( int row = entry.first[1] ; row <= entry.last[1] ; ++row ) {
+    for ( int column = entry.first[0] ; column <= entry.last[0] ; ++column )
+      grid_[ row * cells_[0] + column ].push_back(key);
+  }
+}
+
+
+
+void
+SlSpatialGrid::cellRange(const SDL_Rect& rect, Entry& entry) const
+{
+  entry.first[0] = cellOf( rect.x, cells_[0] );
+  entry.first[1] = cellOf( rect.y, cells_[1] );
+  //! SlSprite::is_inside() includes the right and bottom edge.
+  entry.last[0] = cellOf( rect.x + rect.w, cells_[0] );
+  entry.last[1] = cellOf( rect.y + rect.h, cells_[1] );
+}
+
+
+
+int
+SlSpatialGrid::cellOf(int coordinate, int cells) const
+{
+  if ( coordinate < 0 ) return 0;
+  return std::min( coordinate / cellSize, cells - 1 );
+}
+
+
+
+void
+SlSpatialGrid::clear()
+{
+  for ( auto& cell: grid_ ) cell.clear();
+  entries_.clear();
+  pending_.clear();
+  isBuilt_ = false;
+}
+
+
+
+int
+SlSpatialGrid::pick(const SlRenderQueue& queue, int x, int y)
+{
+  if ( !isBuilt_ ) rebuild(queue);
+  else update(queue);
+
+  int result = -1;
+  const std::vector<SlItemKey>& cell = grid_[ cellOf(y, cells_[1]) * cells_[0] + cellOf(x, cells_[0]) ];
+  for ( const auto& key: cell ) {
+    int position = queue.find( key.first, key.second );
+    if ( queue.count( key.first, key.second ) > 1 ) {
+      //! The same destination is queued more than once, the last one is on top.
+      for ( int i = queue.size() - 1 ; i > result && i >= position ; --i ) {
+        SlRenderItem* item = queue[i];
+        if ( item->sprite_.get() == key.first && item->destination_ == key.second && item->renderMe_ && item->is_inside(x, y) ) {
+          result = i;
+          break;
+        }
+      }
+      continue;
+    }
+    if ( position <= result ) continue;
+    SlRenderItem* item = queue[position];
+    if ( item->renderMe_ && item->is_inside(x, y) ) result = position;
+  }
+  return result;
+}
+
+
+
+void
+SlSpatialGrid::rebuild(const SlRenderQueue& queue)
+{
+  clear();
+  for ( auto item: queue ) {
+    SlItemKey key( item->sprite_.get(), item->destination_ );
+    if ( entries_.count(key) ) continue;
+    Entry& entry = entries_[key];
+    cellRange( item->sprite_->boundingBox( item->destination_ ), entry );
+    addToCells(key, entry);
+  }
+  isBuilt_ = true;
+}
+
+
+
+void
+SlSpatialGrid::removeFromCells(const SlItemKey& key, const Entry& entry)
+{
+  for ( int row = entry.first[1] ; row <= entry.last[1] ; ++row ) {
+    for ( int column = entry.first[0] ; column <= entry.last[0] ; ++column ) {
+      std::vector<SlItemKey>& cell = grid_[ row * cells_[0] + column ];
+      auto iter = std::find( cell.begin(), cell.end(), key );
+      if ( iter == cell.end() ) continue;
+      *iter = cell.back();
+      cell.pop_back();
+    }
+  }
+}
+
+
+
+void
+SlSpatialGrid::setBounds(int width, int height)
+{
+  cells_[0] = std::max( 1, ( width + cellSize - 1 ) / cellSize );
+  cells_[1] = std::max( 1, ( height + cellSize - 1 ) / cellSize );
+  grid_.assign( cells_[0] * cells_[1], std::vector<SlItemKey>() );
+  clear();
+}
+
+
+
+void
+SlSpatialGrid::touch(const SlSprite* sprite, unsigned int destination)
+{
+  if ( !isBuilt_ ) return;
+  SlItemKey key(sprite, destination);
+  Entry& entry = entries_[key];
+  if ( entry.isPending ) return;
+  entry.isPending = true;
+  pending_.push_back(key);
+}
+
+
+
+void
+SlSpatialGrid::update(const SlRenderQueue& queue)
+{
+  for ( const auto& key: pending_ ) {
+    auto iter = entries_.find(key);
+    if ( iter == entries_.end() ) continue;
+    Entry& entry = iter->second;
+    removeFromCells(key, entry);
+    //! The sprite may be deleted already, only items still in the queue are dereferenced.
+    int position = queue.find( key.first, key.second );
+    if ( position < 0 ) {
+      entries_.erase(iter);
+      continue;
+    }
+    SlRenderItem* item = queue[position];
+    entry.isPending = false;
+    cellRange( item->sprite_->boundingBox( item->destination_ ), entry );
+    addToCells(key, entry);
+  }
+  pending_.clear();
+}
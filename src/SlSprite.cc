@@ -9,23 +9,36 @@
 #include <iostream>
 #include <string>
 #include <stdexcept>
+#include <cmath>
+#include <algorithm>
 
 #include <SDL2/SDL.h>
 
 #include "SlTexture.h"
+#include "SlRenderBatch.h"
+#include "SlRenderState.h"
+#include "SlDirtyRegion.h"
+#include "SlSpatialGrid.h"
 #include "SlSprite.h"
 
 
+
+unsigned long SlSprite::versionCount_ = 0;
+
+
+
 SlSprite::SlSprite(const std::string& name, SlTexture* texture, int x, int y, int width, int height)
   : name_(name)
+  , id_( SlSymbolTable::intern(name) )
   , texture_(texture)
 {
+  SDL_Rect region = texture_->region();
   if (width == 0 || height == 0) {   //! assumes whole texture to be used
-    SDL_QueryTexture(texture_->texture(), nullptr, nullptr, &sourceRect_.w, &sourceRect_.h);
+    sourceRect_ = region;
   }
   else {
-    sourceRect_.x = x;
-    sourceRect_.y = y;
+    sourceRect_.x = region.x + x;
+    sourceRect_.y = region.y + y;
     sourceRect_.w = width;
     sourceRect_.h = height;
   }
@@ -44,6 +57,7 @@ SlSprite::SlSprite()
 
 SlSprite::SlSprite(const std::string& name)
   : name_(name)
+  , id_( SlSymbolTable::intern(name) )
 {
 }
 
@@ -59,6 +73,8 @@ SlSprite::SlSprite(SlTexture* texture)
 SlSprite::~SlSprite()
 {
   texture_ = nullptr;
+  dirtyRegion_ = nullptr;
+  spatialGrid_ = nullptr;
 #ifdef DEBUG
   std::cout << "[SlSprite::~SlSprite] deleting sprite " << name_  << std::endl;
 #endif
@@ -72,6 +88,7 @@ SlSprite::addDefaultDestination()
   SlRenderSettings defSet;
   defSet.destinationRect = sourceRect_;
   defSet.destinationRect.x = defSet.destinationRect.y = 0;
+  defSet.version = ++versionCount_;
   destinations_.push_back(defSet);
 
   return this;
@@ -86,6 +103,7 @@ SlSprite::addDestination(int x, int y, uint32_t renderOptions)
   toAdd.destinationRect = sourceRect_;
   toAdd.destinationRect.x = x;
   toAdd.destinationRect.y = y;
+  toAdd.version = ++versionCount_;
   destinations_.push_back(toAdd);
 
   return this;
@@ -93,15 +111,53 @@ SlSprite::addDestination(int x, int y, uint32_t renderOptions)
 
 
 
+void
+SlSprite::addToBatch(SDL_Renderer* renderer, SlRenderBatch& batch, unsigned int i)
+{
+  if (i >= destinations_.size() )
+    throw std::runtime_error("Invalid render destination for " + name_ );
+  batch.add( renderer, texture_->texture(), sourceRect_, destinations_[i] );
+}
+
+
+
+SDL_Rect
+SlSprite::boundingBox(unsigned int i)
+{
+  const SlRenderSettings& dest = destinations_.at(i);
+  if ( dest.angle == 0 ) return dest.destinationRect;
+
+  //! SDL_RenderCopyEx rotates around the centre of the destination.
+  const SDL_Rect& rect = dest.destinationRect;
+  double radians = dest.angle * M_PI / 180.0;
+  double cosAngle = std::fabs( std::cos(radians) );
+  double sinAngle = std::fabs( std::sin(radians) );
+  double halfWidth = 0.5 * ( rect.w * cosAngle + rect.h * sinAngle );
+  double halfHeight = 0.5 * ( rect.w * sinAngle + rect.h * cosAngle );
+  double centerX = rect.x + 0.5 * rect.w;
+  double centerY = rect.y + 0.5 * rect.h;
+
+  SDL_Rect box;
+  box.x = static_cast<int>( std::floor(centerX - halfWidth) );
+  box.y = static_cast<int>( std::floor(centerY - halfHeight) );
+  box.w = static_cast<int>( std::ceil(centerX + halfWidth) ) - box.x;
+  box.h = static_cast<int>( std::ceil(centerY + halfHeight) ) - box.y;
+  return box;
+}
+
+
+
 SlSprite*
 SlSprite::centerAt( unsigned int x, unsigned int y, unsigned int destination)
 {
   if ( destination >= destinations_.size() )
     throw std::invalid_argument("Invalid sprite destination index.");
   
+  markDirty(destination);
   SDL_Rect& dest = destinations_.at(destination).destinationRect ;
   dest.x = x - dest.w / 2 ;
   dest.y = y - dest.h / 2 ;
+  markDirty(destination);
 
   return this;
 }
@@ -114,10 +170,12 @@ SlSprite::centerInSprite(const std::shared_ptr<SlSprite> otherSprite, unsigned i
   if ( destinationThis >= destinations_.size() || destinationOther >= otherSprite->destinations_.size() ) 
     throw std::invalid_argument( "[SlSprite::centerInSprite] Couldn't center " + name_ + " in " + otherSprite->name_ + ": destination out of bounds." );
     
+  markDirty(destinationThis);
   SDL_Rect target = otherSprite->destinations_.at(destinationOther).destinationRect;
   SDL_Rect& dest = destinations_.at(destinationThis).destinationRect ;
   dest.x = target.x + ( target.w - dest.w ) / 2 ;
   dest.y = target.y + ( target.h - dest.h ) / 2 ;
+  markDirty(destinationThis);
 
   return this;
 }
@@ -127,6 +185,9 @@ SlSprite::centerInSprite(const std::shared_ptr<SlSprite> otherSprite, unsigned i
 void
 SlSprite::clearDestinations()
 {
+  for (unsigned int i = 0; i < destinations_.size() ; ++i){
+    markDirty(i);
+  }
   destinations_.clear();
 }
 
@@ -188,59 +249,72 @@ SlSprite::is_inside(const int& x, const int& y, const unsigned int& dest)
 
 
 
+void
+SlSprite::markDirty(unsigned int i)
+{
+  if ( dirtyRegion_ ) dirtyRegion_->add( boundingBox(i) );
+  if ( spatialGrid_ ) spatialGrid_->touch(this, i);
+  destinations_.at(i).version = ++versionCount_;
+}
+
+
+
 void
 SlSprite::moveDestinationOriginBy(int x, int y, unsigned int i)
 {
+  markDirty(i);
   SDL_Rect& destRect = destinations_.at(i).destinationRect;
   destRect.x += x;
   destRect.y += y;
+  markDirty(i);
+}
+
+
+
+void
+SlSprite::moveSourceOriginBy(int x, int y)
+{
+  sourceRect_.x += x;
+  sourceRect_.y += y;
+  for ( unsigned int i = 0 ; i < destinations_.size() ; ++i ) markDirty(i);
 }
 
 
 
 void
-SlSprite::render(SDL_Renderer* renderer)
+SlSprite::render(SDL_Renderer* renderer, SlRenderState& state)
 {
 #ifdef DEBUG
   if (destinations_.size() > 1) std::cout << "[SlSprite::render] " << name_ << ": rendering " << destinations_.size() << " destinations" << std::endl;
 #endif
 
+#if SL_HAVE_RENDER_GEOMETRY
+  if ( destinations_.size() > 1 ) {
+    //! All destinations in one SDL_RenderGeometry call, colour and angle are in the vertices.
+    SlRenderBatch batch(&state);
+    for ( auto& dest: destinations_ ) {
+      batch.add( renderer, texture_->texture(), sourceRect_, dest );
+    }
+    batch.flush( renderer );
+    return;
+  }
+#endif
+
   for (unsigned int i = 0; i < destinations_.size() ; ++i){
-    render(renderer, i);
+    render(renderer, state, i);
   }
 }
 
 
 
 void
-SlSprite::render(SDL_Renderer* renderer, unsigned int i)
+SlSprite::render(SDL_Renderer* renderer, SlRenderState& state, unsigned int i)
 {
   if (i >= destinations_.size() )
     throw std::runtime_error("Invalid render destination for " + name_ );
 
   SlRenderSettings& dest = destinations_.at(i);
-    
-  int modColor = (dest.renderOptions & SL_RENDER_COLORMOD);
-  if ((modColor == SL_RENDER_COLORMOD) && !texture_->colorModIsSet) {
-    SDL_SetTextureColorMod(texture_->texture(), dest.color[0], dest.color[1], dest.color[2] );
-    texture_->colorModIsSet = true;
-  }
-  if (texture_->colorModIsSet && (modColor == 0)) {
-    SDL_SetTextureColorMod(texture_->texture(), 0xFF, 0xFF, 0xFF);
-    texture_->colorModIsSet = false;
-  }
-  
-  int modAlpha = (dest.renderOptions & SL_RENDER_ALPHAMOD);
-  if ((modAlpha == SL_RENDER_ALPHAMOD) && !texture_->alphaModIsSet) {
-    SDL_SetTextureBlendMode( texture_->texture(), SDL_BLENDMODE_BLEND );
-    SDL_SetTextureAlphaMod(texture_->texture(), dest.color[3] );
-    texture_->alphaModIsSet = true;
-  }
-  if (texture_->alphaModIsSet && (modAlpha == 0)){
-    SDL_SetTextureBlendMode( texture_->texture(), SDL_BLENDMODE_NONE );
-    //SDL_SetTextureAlphaMod(texture_, 0xFF );
-    texture_->alphaModIsSet = false;
-  }
+  state.apply( texture_->texture(), dest );
 
   int hasRendered = SDL_RenderCopyEx(renderer, texture_->texture(), &sourceRect_, &dest.destinationRect, dest.angle, NULL, SDL_FLIP_NONE);
   if (hasRendered != 0) {
@@ -250,12 +324,33 @@ SlSprite::render(SDL_Renderer* renderer, unsigned int i)
 
 
 
+void
+SlSprite::resizeSource(const SDL_Rect& oldRegion, const SDL_Rect& newRegion)
+{
+  bool isWhole = ( sourceRect_.x == oldRegion.x && sourceRect_.y == oldRegion.y &&
+		   sourceRect_.w == oldRegion.w && sourceRect_.h == oldRegion.h );
+  for ( unsigned int i = 0 ; i < destinations_.size() ; ++i ) {
+    markDirty(i);
+    SDL_Rect& dest = destinations_[i].destinationRect;
+    if ( isWhole && dest.w == oldRegion.w && dest.h == oldRegion.h ) {
+      dest.w = newRegion.w;
+      dest.h = newRegion.h;
+      markDirty(i);
+    }
+  }
+  if ( isWhole ) sourceRect_ = newRegion;
+}
+
+
+
 void
 SlSprite::setAngle(double angle, unsigned int i)
 {
   if (i >= destinations_.size() )
     throw std::invalid_argument("[SlSprite::setAngle] attempting to access destination " + std::to_string(i) + " out of " + std::to_string( destinations_.size() ) );
+  markDirty(i);
   destinations_.at(i).angle = angle;
+  markDirty(i);
 }
 
 
@@ -271,6 +366,7 @@ SlSprite::setColor(uint8_t red, uint8_t green, uint8_t blue, uint8_t alpha, unsi
   *p = green; ++p;
   *p = blue; ++p;
   *p = alpha; 
+  markDirty(i);
 }
 
 
@@ -281,7 +377,9 @@ SlSprite::setDestination(const SDL_Rect& dstRect, unsigned int i)
 
   if (i >= destinations_.size()) 
     throw std::invalid_argument("[SlSprite::setDestination] attempting to access destination " + std::to_string(i) + " out of " + std::to_string( destinations_.size() ) );
+  markDirty(i);
   destinations_.at(i).destinationRect = dstRect;
+  markDirty(i);
 }
 
 
@@ -303,8 +401,10 @@ SlSprite::setDestinationDimension(int width, int height, unsigned int i)
 {
   if (i >= destinations_.size()) 
     throw std::invalid_argument("[SlSprite::setDestinationDimension] attempting to access destination " + std::to_string(i) + " out of " + std::to_string( destinations_.size() ) );
+  markDirty(i);
   destinations_.at(i).destinationRect.w = width;
   destinations_.at(i).destinationRect.h = height;
+  markDirty(i);
 }
 
 
@@ -314,9 +414,11 @@ SlSprite::setDestinationOrigin(int x, int y, unsigned int i)
 {
   if (i >= destinations_.size()) 
     throw std::invalid_argument("[SlSprite::setDestinationOrigin] attempting to access destination " + std::to_string(i) + " out of " + std::to_string( destinations_.size() ) );
+  markDirty(i);
   SDL_Rect& dest = destinations_.at(i).destinationRect;
   dest.x = x;
   dest.y = y;
+  markDirty(i);
 }
 
 
@@ -327,6 +429,7 @@ SlSprite::setRenderOptions(uint32_t renderOptions, unsigned int i)
   if (i >= destinations_.size()) 
     throw std::invalid_argument("[SlSprite::setRenderOptions] attempting to access destination " + std::to_string(i) + " out of " + std::to_string( destinations_.size() ) );
   destinations_.at(i).renderOptions = renderOptions;
+  markDirty(i);
 }
 
 
@@ -7,18 +7,19 @@
 */
 
 #include <iostream>
-#include <fstream>
-#include <sstream>
 #include <string>
+#include <string_view>
 #include <stdexcept>
 #include <memory>
 #include <algorithm>
-#include <iterator>
 
+#include "SlConfigReader.h"
+#include "SlSceneCache.h"
 #include "SlSprite.h"
 #include "SlTexture.h"
 #include "SlManager.h"
 #include "SlSpriteManipulation.h"
+#include "SlValueParser.h"
 
 #include "SlSpriteManager.h"
 
@@ -63,16 +64,21 @@ SlSpriteManager::centerSpriteInSprite(const std::string& toCenter, const std::st
   
 
 
+void
+SlSpriteManager::addSprite(const std::shared_ptr<SlSprite>& toAdd)
+{
+  sprites_.push_back(toAdd);
+  if ( spritesById_.size() <= toAdd->id() ) spritesById_.resize( toAdd->id() + 1 );
+  spritesById_[ toAdd->id() ] = toAdd;
+}
+
+
+
 bool
 SlSpriteManager::checkSpriteName(const std::string& name)
 {
-  try {
-    findSprite( name );
-    return true;
-  }
-  catch (const std::exception& ) {
-    return false;
-  }
+  SlSymbol id = SlSymbolTable::find(name);
+  return ( id < spritesById_.size() && spritesById_[id] != nullptr );
 }
 
   
@@ -84,6 +90,7 @@ SlSpriteManager::clear()
   }
   manipulations_.clear();
   sprites_.clear();  
+  spritesById_.clear();
 }
 
 
@@ -105,7 +112,9 @@ SlSpriteManager::createSprite(SlTexture* texture, int x, int y, int width, int h
   }
   else {
     toAdd = std::make_shared<SlSprite>(texture->name(), texture, x, y, width, height);
-    sprites_.push_back(toAdd);
+    toAdd->setDirtyRegion( mngr_->dirtyRegion() );
+    toAdd->setSpatialGrid( mngr_->spatialGrid() );
+    addSprite(toAdd);
   }
   return toAdd;
 }
@@ -129,7 +138,9 @@ SlSpriteManager::createSprite(const std::string& name, const std::string& textur
   }
   else {
     toAdd = std::make_shared<SlSprite>(name, tex, x, y, width, height);
-    sprites_.push_back(toAdd);
+    toAdd->setDirtyRegion( mngr_->dirtyRegion() );
+    toAdd->setSpatialGrid( mngr_->spatialGrid() );
+    addSprite(toAdd);
   }
   return toAdd;
 }
@@ -139,14 +150,11 @@ SlSpriteManager::createSprite(const std::string& name, const std::string& textur
 void
 SlSpriteManager::deleteSprite(const std::string& name)
 {
-  std::vector<std::shared_ptr<SlSprite>>::iterator iter;
-  for ( iter=sprites_.begin(); iter != sprites_.end(); ++iter){
-    if ( (*iter)->name() == name){
-      //      delete (*iter);
-      sprites_.erase(iter);
-      break;
-    }
-  }
+  SlSymbol id = SlSymbolTable::find(name);
+  if ( id >= spritesById_.size() || spritesById_[id] == nullptr ) return;
+  auto iter = std::find( sprites_.begin(), sprites_.end(), spritesById_[id] );
+  if ( iter != sprites_.end() ) sprites_.erase(iter);
+  spritesById_[id] = nullptr;
 }
 
 
@@ -157,6 +165,7 @@ SlSpriteManager::deleteSprites(const std::string& textureName)
   for ( int i = sprites_.size()-1; i >= 0 ; --i ) {
     if ( sprites_.at(i)->textureName() == textureName) {
       mngr_->deleteRenderItem( sprites_.at(i)->name() );
+      spritesById_[ sprites_.at(i)->id() ] = nullptr;
       sprites_.erase( sprites_.begin() + i );
     }
   }
@@ -164,16 +173,33 @@ SlSpriteManager::deleteSprites(const std::string& textureName)
 
 
 
+void
+SlSpriteManager::moveSpriteSources(SlTexture* texture, int x, int y)
+{
+  for ( auto& sprite: sprites_ ) {
+    if ( sprite->texture() == texture ) sprite->moveSourceOriginBy(x, y);
+  }
+}
+
+
+
 std::shared_ptr<SlSprite>
 SlSpriteManager::findSprite(const std::string& name)
 {
-  auto iter = std::find_if( sprites_.begin(), sprites_.end() ,
-			    [name](const std::shared_ptr<SlSprite> sprite) -> bool { return sprite->name() == name; } ) ;
-
-  if ( iter == sprites_.end() )
+  SlSymbol id = SlSymbolTable::find(name);
+  if ( id >= spritesById_.size() || spritesById_[id] == nullptr )
     throw std::invalid_argument("[SlSpriteManager::findSprite] Couldn't find sprite " + name );
+  return spritesById_[id];
+}
+
 
-  return *iter;
+
+std::shared_ptr<SlSprite>
+SlSpriteManager::findSprite(SlSymbol id)
+{
+  if ( id >= spritesById_.size() || spritesById_[id] == nullptr )
+    throw std::invalid_argument("[SlSpriteManager::findSprite] Couldn't find sprite " + SlSymbolTable::name(id) );
+  return spritesById_[id];
 }
 
 
@@ -217,42 +243,36 @@ SlSpriteManager::manipulateSprite(const std::string& name, unsigned int destinat
  
 
 void
-SlSpriteManager::parseSprite(std::ifstream& input)
+SlSpriteManager::parseSprite(SlConfigReader& input, SlSceneCache* scene)
 {
-  std::string line, token;
   std::string name, texture;
   std::vector<std::string> location;
   bool endOfConfig = false;
   
-  getline(input,line);
-  while ( !endOfConfig && input ) {
-    std::istringstream stream(line.c_str());
-    stream >> token;
-    if ( token[0] == '#' || token.empty() ) {
+  while ( !endOfConfig && input.nextLine() ) {
+    std::string_view token = input.next();
+    if ( token.empty() || token[0] == '#' ) {
       /* empty line or comment */
     }
     else if ( token == "end" ) {
       endOfConfig = true;
     }
     else if ( token == "name" ) {
-      stream >> name ;
+      name = input.next() ;
     }
     else if ( token == "texture" ) {
-      stream >> texture ;
+      texture = input.next() ;
     }
     else if ( token == "location" ) {
-      std::istream_iterator<std::string> str_iter(stream), eof;
-      location = { str_iter, eof };
+      location.clear();
+      input.rest(location);
     }
     
     else {
 #ifdef DEBUG
-      std::cerr << "[SlSpriteManager::parseSprite] Unknown token " << token << std::endl;
+      std::cerr << "[SlSpriteManager::parseSprite] Unknown token " << token << " in " << input.filename() << ":" << input.lineNumber() << std::endl;
 #endif
     }
-    
-    token.clear();
-    if ( !endOfConfig ) getline(input,line);
   }
 
   if ( name.empty() || texture.empty() ) {
@@ -264,30 +284,33 @@ SlSpriteManager::parseSprite(std::ifstream& input)
   try {
     int loc[4];
     valParser->stringsToNumbers<int>(location, loc, 4);
-    createSprite( name, texture, loc[0], loc[1], loc[2], loc[3] );
+    if ( createSprite( name, texture, loc[0], loc[1], loc[2], loc[3] ) ) {
+      if ( scene ) scene->add( SL_SCENE_SPRITE, {name, texture}, {loc[0], loc[1], loc[2], loc[3]} );
+    }
+    else if ( scene ) scene->markIncomplete();
   }
   catch (const std::exception& expt) {
     std::cerr << "[SlSpriteManager::parseSprite] " << expt.what() << std::endl;
+    if ( scene ) scene->markIncomplete();
   }
   catch (...) {
     std::cerr << "[SlSpriteManager::parseSprite] Unknown exception" << std::endl;
+    if ( scene ) scene->markIncomplete();
   }
 }
 
 
 void
-SlSpriteManager::parseSpriteManipulation(std::ifstream& input)
+SlSpriteManager::parseSpriteManipulation(SlConfigReader& input, SlSceneCache* scene)
 {
-  std::string line, token;
   std::string name, whatToDo;
-  unsigned int destination;
+  unsigned int destination = 0;
+  std::vector<std::string> parameters;
   bool endOfConfig = false;
   
-  getline(input,line);
-  while ( !endOfConfig && input ) {
-    std::istringstream stream(line.c_str());
-    stream >> token;
-    if ( token[0] == '#' || token.empty() ) {
+  while ( !endOfConfig && input.nextLine() ) {
+    std::string_view token = input.next();
+    if ( token.empty() || token[0] == '#' ) {
       /* empty line or comment */
     }
     else if ( token == "end" ) {
@@ -296,21 +319,34 @@ SlSpriteManager::parseSpriteManipulation(std::ifstream& input)
     else {
       try {
 	name = token ;
-	stream >> destination ;
-	stream >> whatToDo ;
-	std::istream_iterator<std::string> str_iter(stream), eof;
-	std::vector<std::string> parameters( str_iter, eof );
+	input.next(destination);
+	whatToDo = input.next();
+	parameters.clear();
+	input.rest(parameters);
 	manipulateSprite( name, destination, whatToDo, parameters );
+	if ( scene )
+	  scene->add( SL_SCENE_SPRITE_MANIPULATION, {name, whatToDo}, {static_cast<int>(destination)}, valParser->resolveFormulas(parameters) );
       }
       catch (const std::exception& expt) {
-	std::cerr << "[SlSpriteManager::parseSpriteManipulation] " << expt.what() << std::endl;
+	std::cerr << "[SlSpriteManager::parseSpriteManipulation] " << input.filename() << ":" << input.lineNumber() << ": " << expt.what() << std::endl;
+	if ( scene ) scene->markIncomplete();
       }
       catch (...) {
-	std::cerr << "[SlSpriteManager::parseSpriteManipulation] Unknown exception at line: " << line << std::endl;
+	std::cerr << "[SlSpriteManager::parseSpriteManipulation] Unknown exception at line: " << input.line() << std::endl;
+	if ( scene ) scene->markIncomplete();
       }
     }
-    token.clear();
-    if ( !endOfConfig ) getline(input,line);
+    destination = 0;
+  }
+}
+
+
+
+void
+SlSpriteManager::resizeSpriteSources(SlTexture* texture, const SDL_Rect& oldRegion, const SDL_Rect& newRegion)
+{
+  for ( auto& sprite: sprites_ ) {
+    if ( sprite->texture() == texture ) sprite->resizeSource(oldRegion, newRegion);
   }
 }
 
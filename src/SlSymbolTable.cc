@@ -0,0 +1,49 @@
+// part of SDL2lazy
+// author: Ulrike Hager
+
+/*! \file SlSymbolTable.cc
+
+  SlSymbolTable implementation
+*/
+
+#include "SlSymbolTable.h"
+
+
+
+std::unordered_map<std::string, SlSymbol> SlSymbolTable::ids_;
+std::deque<std::string> SlSymbolTable::names_(1);
+
+
+
+SlSymbolTable::SlSymbolTable()
+{
+}
+
+
+
+SlSymbol
+SlSymbolTable::find(const std::string& name)
+{
+  auto iter = ids_.find(name);
+  if ( iter == ids_.end() ) return SL_NO_SYMBOL;
+  return iter->second;
+}
+
+
+
+SlSymbol
+SlSymbolTable::intern(const std::string& name)
+{
+  auto result = ids_.emplace( name, names_.size() );
+  if ( result.second ) names_.push_back(name);
+  return result.first->second;
+}
+
+
+
+const std::string&
+SlSymbolTable::name(SlSymbol symbol)
+{
+  if ( symbol >= names_.size() ) return names_.front();
+  return names_[symbol];
+}
@@ -11,6 +11,7 @@
 
 #include "SlSprite.h"
 #include "SlFont.h"
+#include "SlRenderState.h"
 
 #include "SlTexture.h"
 
@@ -27,6 +28,7 @@ SlTexture::SlTexture(const std::string& name)
 {
   texture_ = nullptr;
   name_ = name;
+  id_ = SlSymbolTable::intern(name);
 #ifdef DEBUG
   std::cout << "[SlTexture::SlTexture] Creating " << name_ << std::endl;
 #endif // DEBUG
@@ -39,12 +41,39 @@ SlTexture::~SlTexture()
 #ifdef DEBUG
   std::cout << "[SlTexture::~SlTexture] Deleting " << name_ << std::endl;
 #endif // DEBUG
-  SDL_DestroyTexture(texture_);
+  if ( ownsTexture_ ) SDL_DestroyTexture(texture_);
   texture_ = nullptr;
 }
 
 
 
+std::size_t
+SlTexture::bytes()
+{
+  if ( !ownsTexture_ || texture_ == nullptr ) return 0;
+  uint32_t format;
+  int width, height;
+  if ( SDL_QueryTexture(texture_, &format, nullptr, &width, &height) != 0 ) return 0;
+  std::size_t pixelBytes = SDL_BYTESPERPIXEL(format);
+  if ( pixelBytes == 0 ) pixelBytes = 4;
+  return static_cast<std::size_t>(width) * height * pixelBytes;
+}
+
+
+
+SlTexture*
+SlTexture::createAtlasPage(SDL_Renderer* renderer, SDL_Surface* pixels, SDL_BlendMode blendMode)
+{
+  texture_ = SDL_CreateTextureFromSurface(renderer, pixels);
+  if (texture_ == nullptr) 
+    throw std::runtime_error("Failed to create atlas page " + std::string( SDL_GetError() ));
+  SDL_SetTextureBlendMode( texture_, blendMode );
+
+  return this;
+}
+
+
+
 SlTexture*
 SlTexture::createFromRectangle(SDL_Renderer* renderer, int width, int height, uint8_t red, uint8_t green, uint8_t blue, uint8_t alpha )
 {
@@ -59,6 +88,7 @@ SlTexture::createFromRectangle(SDL_Renderer* renderer, int width, int height, ui
   int check = SDL_RenderFillRect( renderer, &sourceRect );
   if ( check != 0 )
     throw std::runtime_error("Couldn't render rectangle: " + std::string( SDL_GetError() ));
+  isOpaque_ = ( alpha == 0xFF );
   SDL_SetRenderTarget(renderer, nullptr);
   SDL_SetRenderDrawColor( renderer, 0x00, 0x00, 0x00, 0xFF );
   SDL_RenderClear(renderer);
@@ -69,20 +99,23 @@ SlTexture::createFromRectangle(SDL_Renderer* renderer, int width, int height, ui
 
 
 SlTexture*
-SlTexture::createFromSpriteOnTexture(SDL_Renderer *renderer, SlTexture* backgroundTexture, const std::shared_ptr<SlSprite> foregroundSprite)
+SlTexture::createFromSpriteOnTexture(SDL_Renderer *renderer, SlRenderState& state, SlTexture* backgroundTexture, const std::shared_ptr<SlSprite> foregroundSprite)
 {
   int width, height;
-  SDL_QueryTexture(backgroundTexture->texture_, nullptr, nullptr, &width, &height);
+  backgroundTexture->dimensions(width, height);
+  SDL_Rect backgroundRect = backgroundTexture->region();
   texture_ = SDL_CreateTexture(renderer, 0, SDL_TEXTUREACCESS_TARGET, width, height);
   if (texture_ == nullptr) 
     throw std::runtime_error("Failed to create texture " + std::string( SDL_GetError() ));
   
   SDL_RenderClear(renderer);
   SDL_SetRenderTarget(renderer, texture_);
-  int check = SDL_RenderCopy(renderer, backgroundTexture->texture_, nullptr, nullptr);
+  int check = SDL_RenderCopy(renderer, backgroundTexture->texture_, &backgroundRect, nullptr);
   if ( check != 0 )
     throw std::runtime_error("Couldn't render background: " + std::string( SDL_GetError() ));
-  foregroundSprite->render(renderer);
+  foregroundSprite->render(renderer, state);
+  //! Blending onto an opaque background keeps it opaque.
+  isOpaque_ = backgroundTexture->isOpaque();
 
   SDL_SetRenderTarget(renderer, nullptr);
   SDL_SetRenderDrawColor( renderer, 0x00, 0x00, 0x00, 0xFF );
@@ -111,7 +144,7 @@ SlTexture::createFromText(SDL_Renderer *renderer, const std::shared_ptr<SlFont>
 
 
 SlTexture*
-SlTexture::createFromTile(SDL_Renderer *renderer, const std::shared_ptr<SlSprite> tile, int width, int height)
+SlTexture::createFromTile(SDL_Renderer *renderer, SlRenderState& state, const std::shared_ptr<SlSprite> tile, int width, int height)
 {
 
   texture_ = SDL_CreateTexture(renderer, 0, SDL_TEXTUREACCESS_TARGET, width, height);
@@ -140,8 +173,9 @@ SlTexture::createFromTile(SDL_Renderer *renderer, const std::shared_ptr<SlSprite
       currYPos += stepHeight;
     }
   }
-  tile->render(renderer);
+  tile->render(renderer, state);
   tile->clearDestinations();
+  isOpaque_ = tile->texture()->isOpaque();
   
   SDL_SetRenderTarget(renderer, nullptr);
   SDL_RenderClear(renderer);
@@ -151,14 +185,75 @@ SlTexture::createFromTile(SDL_Renderer *renderer, const std::shared_ptr<SlSprite
 
 
 
+SlTexture*
+SlTexture::createPlaceholder(SDL_Renderer* renderer)
+{
+  SDL_Rect placeholder = placeholderRegion();
+  return createFromRectangle( renderer, placeholder.w, placeholder.h, 0x00, 0x00, 0x00, 0x00 );
+}
+
+
+
 void
 SlTexture::dimensions(int& width, int& height)
 {
 
-  if (texture_ == nullptr) 
+  if ( texture_ == nullptr && !isEvicted_ )
     throw std::runtime_error( "[SlTexture::dimensions] no texture for " + name_ );
-  SDL_QueryTexture(texture_, nullptr, nullptr, &width, &height);
+  if ( ownsTexture_ && !isEvicted_ ) {
+    SDL_QueryTexture(texture_, nullptr, nullptr, &width, &height);
+  }
+  else {
+    width = region_.w;
+    height = region_.h;
+  }
+
+}
+
+
 
+void
+SlTexture::evict(SlRenderState& state)
+{
+  if ( isEvicted_ ) return;
+  if ( !ownsTexture_ || file_.empty() )
+    throw std::runtime_error("[SlTexture::evict] Texture " + name_ + " can't be reloaded, not evicting it." );
+  region_ = region();
+  state.forget( texture_ );
+  SDL_DestroyTexture( texture_ );
+  texture_ = nullptr;
+  isEvicted_ = true;
+#ifdef DEBUG
+  std::cout << "[SlTexture::evict] Evicted " << name_ << std::endl;
+#endif // DEBUG
+}
+
+
+
+bool
+SlTexture::hasOnlyOpaquePixels(SDL_Surface* surface)
+{
+  uint32_t colorKey;
+  if ( SDL_GetColorKey(surface, &colorKey) == 0 ) return false;
+  if ( surface->format->Amask == 0 ) return true;
+
+  SDL_Surface* rgba = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_RGBA32, 0);
+  if ( rgba == nullptr ) return false;
+  bool isOpaque = true;
+  SDL_LockSurface(rgba);
+  //! SDL_PIXELFORMAT_RGBA32 is byte order R, G, B, A on all platforms.
+  for ( int row = 0 ; row < rgba->h && isOpaque ; ++row ) {
+    const uint8_t* pixel = static_cast<const uint8_t*>(rgba->pixels) + row * rgba->pitch;
+    for ( int column = 0 ; column < rgba->w ; ++column ) {
+      if ( pixel[4 * column + 3] != 0xFF ) {
+	isOpaque = false;
+	break;
+      }
+    }
+  }
+  SDL_UnlockSurface(rgba);
+  SDL_FreeSurface(rgba);
+  return isOpaque;
 }
 
 
@@ -169,10 +264,95 @@ SlTexture::loadFromFile(SDL_Renderer* renderer, const std::string& fileName)
   if (texture_)
     throw std::runtime_error("Texture " + name_ + " already has a texture." );
   
-  texture_ = IMG_LoadTexture(renderer, fileName.c_str());
+  SDL_Surface* surface = IMG_Load(fileName.c_str());
+  if( surface == nullptr )
+    throw std::runtime_error("Unable to load image " + fileName + " " + SDL_GetError() );
+  return loadFromSurface(renderer, surface, hasOnlyOpaquePixels(surface), fileName);
+}
+
+
+
+SlTexture*
+SlTexture::loadFromSurface(SDL_Renderer* renderer, SDL_Surface* surface, bool isOpaque, const std::string& fileName)
+{
+  if (texture_) {
+    SDL_FreeSurface(surface);
+    throw std::runtime_error("Texture " + name_ + " already has a texture." );
+  }
+  isOpaque_ = isOpaque;
+  texture_ = SDL_CreateTextureFromSurface(renderer, surface);
+  SDL_FreeSurface(surface);
   
   if( texture_ == nullptr )
     throw std::runtime_error("Unable to create texture from " + fileName + " " + SDL_GetError() );
+  file_ = fileName;
+
+  return this;
+}
+
+
+
+void
+SlTexture::moveToAtlas(SlRenderState& state, SlTexture* page, int x, int y)
+{
+  if ( !ownsTexture_ )
+    throw std::runtime_error("Texture " + name_ + " is already in an atlas." );
+
+  SDL_Rect target = region();
+  target.x = x;
+  target.y = y;
+
+  state.forget( texture_ );
+  SDL_DestroyTexture( texture_ );
+  texture_ = page->texture_;
+  ownsTexture_ = false;
+  region_ = target;
+}
+
+
+
+SDL_Rect
+SlTexture::region()
+{
+  if ( !ownsTexture_ || isEvicted_ ) return region_;
+  SDL_Rect whole = {0,0,0,0};
+  SDL_QueryTexture(texture_, nullptr, nullptr, &whole.w, &whole.h);
+  return whole;
+}
+
+
+
+SlTexture*
+SlTexture::reload(SDL_Renderer* renderer)
+{
+  if ( !isEvicted_ ) return this;
+  std::string fileName = file_;
+  loadFromFile(renderer, fileName);
+  isEvicted_ = false;
+  return this;
+}
+
+
+
+SlTexture*
+SlTexture::replaceFromSurface(SDL_Renderer* renderer, SlRenderState& state, SDL_Surface* surface, bool isOpaque, const std::string& fileName)
+{
+  if ( !ownsTexture_ ) {
+    SDL_FreeSurface(surface);
+    throw std::runtime_error("Texture " + name_ + " is in an atlas, can't replace it." );
+  }
+  SDL_Texture* replacement = SDL_CreateTextureFromSurface(renderer, surface);
+  SDL_FreeSurface(surface);
+  if( replacement == nullptr )
+    throw std::runtime_error("Unable to create texture from " + fileName + " " + SDL_GetError() );
+
+  if ( texture_ ) {
+    state.forget( texture_ );
+    SDL_DestroyTexture( texture_ );
+  }
+  texture_ = replacement;
+  isOpaque_ = isOpaque;
+  file_ = fileName;
 
   return this;
 }
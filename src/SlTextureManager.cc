@@ -7,13 +7,14 @@
 */
 
 #include <iostream>
-#include <fstream>
-#include <sstream>
+#include <string_view>
 #include <stdexcept>
 #include <algorithm>
 
 #include "SDL2/SDL_ttf.h"
 
+#include "SlConfigReader.h"
+#include "SlSceneCache.h"
 #include "SlTexture.h"
 #include "SlSprite.h"
 #include "SlManager.h"
@@ -53,6 +54,8 @@ SlTextureManager::addTexture(SlTexture* toAdd)
 {
   if ( toAdd == nullptr ) return;
   textures_.push_back(toAdd);
+  if ( texturesById_.size() <= toAdd->id() ) texturesById_.resize( toAdd->id() + 1, nullptr );
+  texturesById_[ toAdd->id() ] = toAdd;
 }
 
 
@@ -65,7 +68,52 @@ SlTextureManager::clear()
     delete (*iter);
   }
   textures_.clear();
+  texturesById_.clear();
+  for ( iter=atlasPages_.begin(); iter != atlasPages_.end(); ++iter){
+    mngr_->renderState().forget( (*iter)->texture() );
+    delete (*iter);
+  }
+  atlasPages_.clear();
   fonts_.clear();
+  fontsById_.clear();
+  streaming_.clear();
+  prefetched_.clear();
+  imageLoader_.clear();
+  releaseAtlasImages();
+}
+
+
+
+std::shared_ptr<SlFont>
+SlTextureManager::createFont(const std::string& name, const std::string& filename, int size, const short color[4])
+{
+  std::shared_ptr<SlFont> toAdd = std::make_shared<SlFont>(name);
+  std::copy( color, color + 4, toAdd->color );
+  toAdd->loadFont(filename, size);
+  fonts_.push_back(toAdd);
+  if ( fontsById_.size() <= toAdd->id() ) fontsById_.resize( toAdd->id() + 1 );
+  fontsById_[ toAdd->id() ] = toAdd;
+  return toAdd;
+}
+
+
+
+SlTexture*
+SlTextureManager::createTextureAsync(const std::string& name, const std::string& filename)
+{
+  SlTexture* toAdd = findTexture(name);
+  if ( toAdd ) {
+#ifdef DEBUG
+    std::cout << "[SlTextureManager::createTextureAsync] Error: texture of name " << name << " already exists."  << std::endl;
+#endif
+    return nullptr;
+  }
+  toAdd = new SlTexture(name);
+  toAdd->createPlaceholder(mngr_->renderer());
+  addTexture(toAdd);
+  imageLoader_.prefetch(filename);
+  streaming_.emplace_back(toAdd, filename);
+  return toAdd;
 }
 
 
@@ -81,7 +129,23 @@ SlTextureManager::createTextureFromFile(const std::string& name, const std::stri
     return nullptr;
   }
   toAdd = new SlTexture(name);
-  toAdd->loadFromFile(mngr_->renderer(), filename);
+  SDL_Surface* surface;
+  bool isOpaque;
+  if ( imageLoader_.take(filename, surface, isOpaque) ) {
+    //! loadFromSurface() frees the surface, images small enough for an atlas page keep a reference for packAtlas().
+    bool isKept = ( surface && 2 * surface->w <= atlasImageSize_ && 2 * surface->h <= atlasImageSize_ );
+    if ( isKept ) ++surface->refcount;
+    try {
+      toAdd->loadFromSurface(mngr_->renderer(), surface, isOpaque, filename);
+    }
+    catch (...) {
+      if ( isKept ) SDL_FreeSurface(surface);
+      throw;
+    }
+    if ( isKept ) atlasImages_[toAdd] = surface;
+  }
+  else
+    toAdd->loadFromFile(mngr_->renderer(), filename);
   addTexture(toAdd);
   return toAdd;
 }
@@ -125,8 +189,10 @@ SlTextureManager::createTextureFromSpriteOnTexture(const std::string& name, cons
     return toAdd;
   }
   std::shared_ptr<SlSprite> foreground = mngr_->findSprite(foregroundSprite);
+  touchTexture(background);
+  touchTexture( foreground->texture() );
   toAdd = new SlTexture(name);
-  toAdd->createFromSpriteOnTexture(mngr_->renderer(), background, foreground);
+  toAdd->createFromSpriteOnTexture(mngr_->renderer(), mngr_->renderState(), background, foreground);
   addTexture(toAdd);
   return toAdd;
 }
@@ -171,9 +237,10 @@ SlTextureManager::createTextureFromTile(const std::string& name, const std::stri
   }
 
   std::shared_ptr<SlSprite> tile = mngr_->findSprite(sprite);
+  touchTexture( tile->texture() );
 
   toAdd = new SlTexture(name);
-  toAdd->createFromTile(mngr_->renderer(), tile, width, height);
+  toAdd->createFromTile(mngr_->renderer(), mngr_->renderState(), tile, width, height);
   addTexture(toAdd);
   return toAdd;
 }
@@ -183,14 +250,61 @@ SlTextureManager::createTextureFromTile(const std::string& name, const std::stri
 void
 SlTextureManager::deleteTexture(const std::string& name)
 {
-  std::vector<SlTexture*>::iterator iter;
-  for ( iter=textures_.begin(); iter != textures_.end(); ++iter){
-    if ( (*iter)->name() == name){
-      delete (*iter);
-      textures_.erase(iter);
-      break;
+  SlTexture* toDelete = findTexture(name);
+  if ( toDelete == nullptr ) return;
+  texturesById_[ toDelete->id() ] = nullptr;
+  textures_.erase( std::find( textures_.begin(), textures_.end(), toDelete ) );
+  streaming_.erase( std::remove_if( streaming_.begin(), streaming_.end(),
+				    [toDelete](const std::pair<SlTexture*, std::string>& entry) -> bool { return entry.first == toDelete; } ),
+		    streaming_.end() );
+  auto kept = atlasImages_.find(toDelete);
+  if ( kept != atlasImages_.end() ) {
+    SDL_FreeSurface(kept->second);
+    atlasImages_.erase(kept);
+  }
+  if ( toDelete->ownsTexture() ) mngr_->renderState().forget( toDelete->texture() );
+  delete toDelete;
+}
+
+
+
+unsigned int
+SlTextureManager::enforceBudget()
+{
+  std::size_t resident = 0;
+  std::vector<SlTexture*> candidates;
+  for ( auto texture: textures_ ) {
+    resident += texture->bytes();
+    if ( texture->ownsTexture() && !texture->file().empty() && !texture->isEvicted() && texture->lastUsed() < frame_ )
+      candidates.push_back(texture);
+  }
+  for ( auto page: atlasPages_ ) resident += page->bytes();
+
+  unsigned int evicted = 0;
+  if ( budget_ > 0 && resident > budget_ ) {
+    std::sort( candidates.begin(), candidates.end(),
+	       [](const SlTexture* a, const SlTexture* b) -> bool { return a->lastUsed() < b->lastUsed(); } );
+    for ( auto texture: candidates ) {
+      if ( resident <= budget_ ) break;
+      std::size_t bytes = texture->bytes();
+      try {
+	texture->evict( mngr_->renderState() );
+      }
+      catch (const std::exception& expt) {
+	std::cerr << "[SlTextureManager::enforceBudget] " << expt.what() << std::endl;
+	continue;
+      }
+      resident -= bytes;
+      ++evicted;
     }
+#ifdef DEBUG
+    if ( resident > budget_ )
+      std::cout << "[SlTextureManager::enforceBudget] Textures in use need " << resident << " bytes, over the budget of " << budget_ << std::endl;
+#endif
   }
+  stats_.evictions += evicted;
+  stats_.residentBytes = resident;
+  return evicted;
 }
 
 
@@ -198,77 +312,256 @@ SlTextureManager::deleteTexture(const std::string& name)
 std::shared_ptr<SlFont>
 SlTextureManager::findFont(const std::string& name)
 {
-  std::shared_ptr<SlFont> found = nullptr;
-  auto iter = std::find_if( fonts_.begin(), fonts_.end(), 
-			    [name](const std::shared_ptr<SlFont> font) -> bool {return font->name() == name; } );
-  if ( iter == fonts_.end() ) {
+  return findFont( SlSymbolTable::find(name) );
+}
+
+
+
+std::shared_ptr<SlFont>
+SlTextureManager::findFont(SlSymbol id)
+{
+  if ( id >= fontsById_.size() || fontsById_[id] == nullptr ) {
 #ifdef DEBUG
-    std::cout << "[SlTextureManager::findFont] Couldn't find font " << name << std::endl;
+    std::cout << "[SlTextureManager::findFont] Couldn't find font " << SlSymbolTable::name(id) << std::endl;
 #endif
-    return found;
+    return nullptr;
   }
-  found = *iter;
-  return found;
+  return fontsById_[id];
 }
 
 
+
 SlTexture*
 SlTextureManager::findTexture(const std::string& name)
 {
-  SlTexture* result = nullptr;
-  auto iter = std::find_if( textures_.begin(), textures_.end(),
-			    [name](const SlTexture* tex) -> bool {return tex->name() == name; });
-  if ( iter == textures_.end() ) {
-    return result;
-  }
-  result = *iter;
-  return result;
+  return findTexture( SlSymbolTable::find(name) );
+}
+
+
+
+SlTexture*
+SlTextureManager::findTexture(SlSymbol id)
+{
+  if ( id >= texturesById_.size() ) return nullptr;
+  return texturesById_[id];
+}
+
+
+
+std::vector<SlTexture*>
+SlTextureManager::packAtlas(int pageSize)
+{
+  std::vector<SlTexture*> moved;
+  SDL_Renderer* renderer = mngr_->renderer();
+  SDL_RendererInfo info;
+  if ( SDL_GetRendererInfo(renderer, &info) == 0 ) {
+    if ( info.max_texture_width > 0 ) pageSize = std::min( pageSize, info.max_texture_width );
+    if ( info.max_texture_height > 0 ) pageSize = std::min( pageSize, info.max_texture_height );
+  }
+
+  const int padding = 1;
+  struct Placement {
+    SlTexture* texture;
+    int width, height;
+    SDL_BlendMode blendMode;
+    unsigned int page;
+    int x, y;
+  };
+  std::vector<Placement> placements;
+  for ( auto texture: textures_ ) {
+    if ( !texture->ownsTexture() || texture->file().empty() || texture->isEvicted() ) continue;
+    int width, height;
+    texture->dimensions(width, height);
+    if ( 2 * width > pageSize || 2 * height > pageSize ) continue;
+    placements.push_back( {texture, width, height, mngr_->renderState().defaultBlendMode( texture->texture() ), 0, 0, 0} );
+  }
+  //! A page has one blend mode, images without alpha channel go onto their own pages so that they are still drawn without blending. Tallest first keeps the shelves full.
+  std::stable_sort( placements.begin(), placements.end(),
+		    [](const Placement& a, const Placement& b) -> bool {
+		      return ( a.blendMode != b.blendMode ? a.blendMode < b.blendMode : a.height > b.height ); } );
+
+  std::vector<unsigned int> pageCount(1, 0);
+  int x = 0, y = 0, shelfHeight = 0;
+  SDL_BlendMode blendMode = SDL_BLENDMODE_NONE;
+  for ( auto& placement: placements ) {
+    bool isOtherMode = ( pageCount.back() > 0 && placement.blendMode != blendMode );
+    if ( !isOtherMode && x + placement.width > pageSize ) {
+      x = 0;
+      y += shelfHeight + padding;
+      shelfHeight = 0;
+    }
+    if ( isOtherMode || y + placement.height > pageSize ) {
+      pageCount.push_back(0);
+      x = 0;
+      y = 0;
+      shelfHeight = 0;
+    }
+    placement.page = pageCount.size() - 1;
+    placement.x = x;
+    placement.y = y;
+    ++pageCount.back();
+    x += placement.width + padding;
+    shelfHeight = std::max( shelfHeight, placement.height );
+    blendMode = placement.blendMode;
+  }
+
+  //! The pages are built from the decoded images instead of copying the SDL_Textures into a render target: static textures keep their pixels when the render targets are reset.
+  auto first = placements.begin();
+  while ( first != placements.end() ) {
+    auto last = first;
+    while ( last != placements.end() && last->page == first->page ) ++last;
+    if ( last - first < 2 ) {
+      first = last;
+      continue;
+    }
+    for ( auto iter = first ; iter != last ; ++iter ) {
+      if ( atlasImages_.count( iter->texture ) == 0 ) imageLoader_.prefetch( iter->texture->file() );
+    }
+    SDL_Surface* pixels = SDL_CreateRGBSurfaceWithFormat( 0, pageSize, pageSize, 32, SDL_PIXELFORMAT_RGBA32 );
+    if ( pixels == nullptr ) {
+      std::cerr << "[SlTextureManager::packAtlas] Couldn't create atlas surface: " << SDL_GetError() << std::endl;
+      for ( auto iter = first ; iter != last ; ++iter ) {
+	if ( atlasImages_.count( iter->texture ) == 0 ) imageLoader_.drop( iter->texture->file() );
+      }
+      first = last;
+      continue;
+    }
+
+    std::vector<const Placement*> copied;
+    for ( auto iter = first ; iter != last ; ++iter ) {
+      const std::string& file = iter->texture->file();
+      SDL_Surface* image = nullptr;
+      auto kept = atlasImages_.find( iter->texture );
+      if ( kept != atlasImages_.end() ) {
+	image = kept->second;
+	atlasImages_.erase(kept);
+      }
+      else {
+	try {
+	  bool isOpaque;
+	  //! Another texture of the same file may have taken the decoded surface already.
+	  if ( !imageLoader_.take( file, image, isOpaque ) ) image = IMG_Load( file.c_str() );
+	}
+	catch (const std::exception& expt) {
+	  std::cerr << "[SlTextureManager::packAtlas] " << expt.what() << std::endl;
+	  continue;
+	}
+      }
+      if ( image == nullptr ) {
+	std::cerr << "[SlTextureManager::packAtlas] Unable to load image " << file << " " << SDL_GetError() << std::endl;
+	continue;
+      }
+      //! Skip images that changed size since the texture was loaded.
+      SDL_Rect target = { iter->x, iter->y, iter->width, iter->height };
+      SDL_SetSurfaceBlendMode( image, SDL_BLENDMODE_NONE );
+      if ( image->w == iter->width && image->h == iter->height && SDL_BlitSurface( image, nullptr, pixels, &target ) == 0 )
+	copied.push_back( &*iter );
+      SDL_FreeSurface(image);
+    }
+
+    if ( copied.size() > 1 ) {
+      try {
+	std::unique_ptr<SlTexture> page( new SlTexture("atlas" + std::to_string( atlasPages_.size() )) );
+	page->createAtlasPage( renderer, pixels, first->blendMode );
+	atlasPages_.push_back( page.release() );
+	for ( auto placement: copied ) {
+	  placement->texture->moveToAtlas( mngr_->renderState(), atlasPages_.back(), placement->x, placement->y );
+	  moved.push_back(placement->texture);
+	}
+      }
+      catch (const std::exception& expt) {
+	std::cerr << "[SlTextureManager::packAtlas] " << expt.what() << std::endl;
+      }
+    }
+    SDL_FreeSurface(pixels);
+    first = last;
+  }
+  releaseAtlasImages();
+#ifdef DEBUG
+  std::cout << "[SlTextureManager::packAtlas] Packed " << moved.size() << " textures into " << atlasPages_.size() << " pages." << std::endl;
+#endif
+  return moved;
+}
+
+
+
+void
+SlTextureManager::prefetchImage(const std::string& filename)
+{
+  imageLoader_.prefetch(filename);
+  prefetched_.push_back(filename);
+}
+
+
+
+void
+SlTextureManager::prefetchImages(SlConfigReader& input)
+{
+  //! Every section of a configuration file ends with "end", only texture sections are read. Textures loaded async are queued by createTextureAsync(), after the ones the parser waits for.
+  bool isSection = false, isTexture = false;
+  std::string_view type, file, load;
+  while ( input.nextLine() ) {
+    std::string_view token = input.next();
+    if ( token.empty() || token[0] == '#' ) {
+      /* empty line or comment */
+    }
+    else if ( !isSection ) {
+      isTexture = ( token == "texture" );
+      isSection = ( isTexture || token == "sprite" || token == "manipulate" || token == "font" || token == "renderqueue" || token == "event" );
+      type = file = load = std::string_view();
+    }
+    else if ( token == "end" ) {
+      if ( isTexture && type == "file" && load != "async" && !file.empty() ) prefetchImage( std::string(file) );
+      isSection = isTexture = false;
+    }
+    else if ( isTexture && token == "type" ) {
+      type = input.next();
+    }
+    else if ( isTexture && token == "file" ) {
+      file = input.next();
+    }
+    else if ( isTexture && token == "load" ) {
+      load = input.next();
+    }
+  }
 }
 
 
 
 std::shared_ptr<SlFont>
-SlTextureManager::parseFont(std::ifstream& input)
+SlTextureManager::parseFont(SlConfigReader& input, SlSceneCache* scene)
 {
   std::shared_ptr<SlFont> toAdd = nullptr;
-  std::string line, token;
   bool endOfConfig = false;
   std::string name, file;
   std::vector<std::string> colors;
   int fontsize = 0;
   
-  getline(input,line);
-  while ( !endOfConfig && input ) {
-    std::istringstream stream(line.c_str());
-    stream >> token;
-    if ( token[0] == '#' || token.empty() || token[0] == '\n' ) {
+  while ( !endOfConfig && input.nextLine() ) {
+    std::string_view token = input.next();
+    if ( token.empty() || token[0] == '#' ) {
       /* empty line or comment */
     }
     else if ( token == "end" ) {
       endOfConfig = true;
     }
     else if ( token == "name" ) {
-      stream >> name ;
+      name = input.next() ;
     }
     else if ( token == "file" ) {
-      stream >> file ;
+      file = input.next() ;
     }
     else if ( token == "size" ) {
-      stream >> fontsize;
+      input.next(fontsize);
     }
     else if ( token == "color" || token == "colour") {
-      while ( !stream.eof() ){
-	colors.push_back("");
-	stream >> colors.back();
-      }
+      input.rest(colors);
     }
     else {
 #ifdef DEBUG
-      std::cerr << "[SlTextureManager::parseFont] Unknown token " << token << std::endl;
+      std::cerr << "[SlTextureManager::parseFont] Unknown token " << token << " in " << input.filename() << ":" << input.lineNumber() << std::endl;
 #endif
     }
-    token.clear();
-    if (  !endOfConfig ) getline(input,line);
   }
 
   if ( name.empty() ) {
@@ -285,10 +578,11 @@ SlTextureManager::parseFont(std::ifstream& input)
   }
 
   try {
-  toAdd = std::make_shared<SlFont>(name);
-  valParser->stringsToNumbers<short>( colors, toAdd->color, 4 );
-  toAdd->loadFont(file, fontsize);
-  fonts_.push_back(toAdd);
+  short color[4];
+  valParser->stringsToNumbers<short>( colors, color, 4 );
+  toAdd = createFont( name, file, fontsize, color );
+  if ( scene )
+    scene->add( SL_SCENE_FONT, {name, file}, {fontsize, color[0], color[1], color[2], color[3]} );
   }
   catch (const std::exception& expt){
     std::cout << "[SlTextureManager::parseFont] " << expt.what() << std::endl; 
@@ -296,6 +590,7 @@ SlTextureManager::parseFont(std::ifstream& input)
   catch (...) {
     std::cerr << "[SlTextureManager::parseFont] Unknown exception for " << name  << std::endl;
   }
+  if ( toAdd == nullptr && scene ) scene->markIncomplete();
   return toAdd;
 }
 
@@ -303,66 +598,57 @@ SlTextureManager::parseFont(std::ifstream& input)
 
 
 SlTexture*
-SlTextureManager::parseTexture(std::ifstream& input)
+SlTextureManager::parseTexture(SlConfigReader& input, SlSceneCache* scene)
 {
   SlTexture* toAdd = nullptr;
-  std::string line, token;
   bool endOfConfig = false;
-  std::string name, type, file, sprite, font, texture, message;
+  std::string name, type, file, sprite, font, texture, message, load;
   std::vector<std::string> dimensions;
   std::vector<std::string> colors;
   
-  getline(input,line);
-  while ( !endOfConfig && input ) {
-    std::istringstream stream(line.c_str());
-    stream >> token;
-    if ( token[0] == '#' || token.empty() || token[0] == '\n' ) {
+  while ( !endOfConfig && input.nextLine() ) {
+    std::string_view token = input.next();
+    if ( token.empty() || token[0] == '#' ) {
       /* empty line or comment */
     }
     else if ( token == "end" ) {
       endOfConfig = true;
     }
     else if ( token == "type" ) {
-      stream >> type;
+      type = input.next();
     }
     else if ( token == "name" ) {
-      stream >> name ;
+      name = input.next() ;
     }
     else if ( token == "sprite" ) {
-      stream >> sprite;
+      sprite = input.next();
     }
     else if ( token == "file" ) {
-      stream >> file ;
+      file = input.next() ;
+    }
+    else if ( token == "load" ) {
+      load = input.next() ;
     }
     else if ( token == "font" ) {
-      stream >> font ;
+      font = input.next() ;
     }
     else if ( token == "text" ) {
-    getline(stream, message);
-    message = message.substr(1);   //! <- message[0] is space between token and beginning of text.
+      message = input.rest();
     }
     else if ( token == "texture" ) {
-      stream >> texture ;
+      texture = input.next() ;
     }
     else if ( token == "dimensions" || token == "width" ) {
-      while ( !stream.eof() ){
-	dimensions.push_back("");
-	stream >> dimensions.back();
-      }
+      input.rest(dimensions);
     }
     else if ( token == "color" || token == "colour") {
-      while ( !stream.eof() ){
-	colors.push_back("");
-	stream >> colors.back();
-      }
+      input.rest(colors);
     }
     else {
 #ifdef DEBUG
-      std::cerr << "[SlTextureManager::parseTexture] Unknown token " << token << std::endl;
+      std::cerr << "[SlTextureManager::parseTexture] Unknown token " << token << " in " << input.filename() << ":" << input.lineNumber() << std::endl;
 #endif
     }
-    token.clear();
-    if (  !endOfConfig ) getline(input,line);
   }
 
   if ( name.empty() ) {
@@ -373,8 +659,13 @@ SlTextureManager::parseTexture(std::ifstream& input)
   }
 
   try {  
-    if ( type == "file" ) {
+    if ( type == "file" && load == "async" ) {
+      toAdd = createTextureAsync( name, file );
+      if ( toAdd && scene ) scene->add( SL_SCENE_TEXTURE_ASYNC, {name, file}, {} );
+    }
+    else if ( type == "file" ) {
       toAdd = createTextureFromFile( name, file );
+      if ( toAdd && scene ) scene->add( SL_SCENE_TEXTURE_FILE, {name, file}, {} );
     }
   
     else if ( type == "tile" || type == "rectangle" ) {
@@ -383,22 +674,26 @@ SlTextureManager::parseTexture(std::ifstream& input)
 
       if ( type == "tile") {
 	toAdd = createTextureFromTile( name, sprite, dim[0], dim[1] );
+	if ( toAdd && scene ) scene->add( SL_SCENE_TEXTURE_TILE, {name, sprite}, {dim[0], dim[1]} );
       }
 
       else if ( type == "rectangle" ) {
 	short colArray[] = {0,0,0,0};
 	valParser->stringsToNumbers<short>( colors, colArray, 4 );
 	toAdd = createTextureFromRectangle( name, dim[0], dim[1], colArray[0], colArray[1], colArray[2], colArray[3] );
+	if ( toAdd && scene ) scene->add( SL_SCENE_TEXTURE_RECTANGLE, {name}, {dim[0], dim[1], colArray[0], colArray[1], colArray[2], colArray[3]} );
       }
     }
 
     else if ( type == "sprite-on-texture" ) {
       toAdd = createTextureFromSpriteOnTexture( name, texture, sprite ) ;
+      if ( toAdd && scene ) scene->add( SL_SCENE_TEXTURE_SPRITE_ON_TEXTURE, {name, texture, sprite}, {} );
     }
     else if ( type == "text" ) {
       int width[1];
       valParser->stringsToNumbers<int>(dimensions, width, 1);
       toAdd = createTextureFromText( name, font, message, width[0] ) ;
+      if ( toAdd && scene ) scene->add( SL_SCENE_TEXTURE_TEXT, {name, font, message}, {width[0]} );
     }
     else {
 #ifdef DEBUG
@@ -412,8 +707,80 @@ SlTextureManager::parseTexture(std::ifstream& input)
   catch (...) {
     std::cout << "[SlTextureManager::parseTexture] Unknown exception" << std::endl;
   }
+  //! The failed texture isn't recorded, don't cache a scene without it.
+  if ( toAdd == nullptr && scene ) scene->markIncomplete();
   return toAdd;
 }
 
 
 
+void
+SlTextureManager::releaseAtlasImages()
+{
+  for ( auto& kept: atlasImages_ ) SDL_FreeSurface(kept.second);
+  atlasImages_.clear();
+}
+
+
+
+void
+SlTextureManager::releasePrefetched()
+{
+  for ( const auto& filename: prefetched_ ) {
+    bool isStreaming = std::any_of( streaming_.begin(), streaming_.end(),
+				    [&filename](const std::pair<SlTexture*, std::string>& entry) -> bool { return entry.second == filename; } );
+    if ( !isStreaming ) imageLoader_.drop(filename);
+  }
+  prefetched_.clear();
+}
+
+
+
+std::vector<SlTexture*>
+SlTextureManager::streamTextures()
+{
+  std::vector<SlTexture*> replaced;
+  for ( auto iter = streaming_.begin() ; iter != streaming_.end() ; ) {
+    if ( !imageLoader_.isReady(iter->second) ) {
+      ++iter;
+      continue;
+    }
+    try {
+      SDL_Surface* surface;
+      bool isOpaque;
+      if ( !imageLoader_.take(iter->second, surface, isOpaque) ) {
+	//! Another texture of the same file took the surface, decode it again.
+	imageLoader_.prefetch(iter->second);
+	++iter;
+	continue;
+      }
+      iter->first->replaceFromSurface( mngr_->renderer(), mngr_->renderState(), surface, isOpaque, iter->second );
+      replaced.push_back(iter->first);
+    }
+    catch (const std::exception& expt) {
+      std::cerr << "[SlTextureManager::streamTextures] " << iter->first->name() << ": " << expt.what() << std::endl;
+    }
+    iter = streaming_.erase(iter);
+  }
+#ifdef DEBUG
+  if ( !replaced.empty() )
+    std::cout << "[SlTextureManager::streamTextures] Replaced " << replaced.size() << " placeholders, " << streaming_.size() << " still loading." << std::endl;
+#endif
+  return replaced;
+}
+
+
+
+bool
+SlTextureManager::touchTexture(SlTexture* texture)
+{
+  if ( texture == nullptr || texture->lastUsed() == frame_ ) return false;
+  texture->setLastUsed(frame_);
+  if ( !texture->isEvicted() ) {
+    ++stats_.hits;
+    return false;
+  }
+  ++stats_.misses;
+  texture->reload( mngr_->renderer() );
+  return true;
+}
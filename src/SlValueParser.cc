@@ -6,15 +6,13 @@
   SlValueParser implementation
 */
 
+#include <cstdio>
 #include <iostream>
 #include <algorithm>
 #include <sstream>
 #include <stdexcept>
-#include <stack>
-#include <queue>
 
 #include "SlRenderOptions.h" 
-#include "SlFormulaItem.h"
 
 #include "SlValueParser.h"
 
@@ -33,6 +31,7 @@ SlValueParser::SlValueParser(const SlValueParser& toCopy)
 {
   screen_width_ = toCopy.screen_width_;
   screen_height_ = toCopy.screen_height_;
+  formulas_ = toCopy.formulas_;
 }
 
 
@@ -42,6 +41,7 @@ SlValueParser::operator=(const SlValueParser& rhs)
 {
   screen_width_ = rhs.screen_width_;
   screen_height_ = rhs.screen_height_;
+  formulas_ = rhs.formulas_;
   return *this;
 }
 
@@ -78,57 +78,17 @@ SlValueParser::assembleFormula(const std::vector<std::string>& stringValues, uns
 
 
 
-double
-SlValueParser::calculateFormula(std::queue<SlFormulaItem>& outputQueue)
+std::shared_ptr<const SlFormula>
+SlValueParser::compileFormula(const std::string& formula)
 {
-  std::stack<SlFormulaItem> tempStorage; 
+  auto iter = formulas_.find(formula);
+  if ( iter != formulas_.end() ) return iter->second;
+  std::shared_ptr<const SlFormula> compiled = std::make_shared<SlFormula>(formula);
 #ifdef DEBUG
-  std::cout << "[SlValueParser::calculateFormula] ";
+  std::cout << "[SlValueParser::compileFormula] \"" << formula << "\" compiled to " << compiled->size() << " instructions" << std::endl;
 #endif //DEBUG
-
-  for ( ; !outputQueue.empty() ; outputQueue.pop() ) {
-    SlFormulaItem item = outputQueue.front();
-#ifdef DEBUG
-    std::cout << item.print() << " " ;
-#endif //DEBUG
-    if ( item.what == 'n' ) {   //!< number
-      tempStorage.push(item);
-    }
-    else {
-      if ( tempStorage.size() < 2 )   //!< need two numbers to use operator
-	throw std::runtime_error("Bad formula");
-      
-      SlFormulaItem operants[2] ;
-      for ( int j=0 ; j<2 ; j++ ){
-	operants[j] = tempStorage.top();
-	tempStorage.pop();
-      }
-      switch ( item.what ){
-      case '+':
-	tempStorage.push( operants[1] + operants[0] );
-	break;
-      case '-':
-	tempStorage.push( operants[1] - operants[0] );
-	break;
-      case '*':
-	tempStorage.push( operants[1] * operants[0] );
-	break;
-      case '/':
-	tempStorage.push( operants[1] / operants[0] );
-	break;
-      default:
-	throw std::runtime_error("Unknown operator: " + item.what );
-      }
-    }
-  }
-
-  if ( tempStorage.size() != 1 )
-    throw std::runtime_error("Bad formula.");
-  
-#ifdef DEBUG
-  std::cout << " = " << tempStorage.top().data << std::endl;
-#endif //DEBUG
-  return tempStorage.top().data;
+  formulas_.emplace(formula, compiled);
+  return compiled;
 }
 
 
@@ -161,94 +121,32 @@ SlValueParser::doubleFromString(const std::string& svalue, double& dvalue)
 
 
 
-SlFormulaItem
-SlValueParser::getNextItem(std::string& formula)
-{
-  decltype( formula.find_first_of("+") ) pos = 0;
-  switch (formula[0] ){
-  case '+': case '-': case '*': case '/': case '(': case ')':
-    pos = 1;
-    break;
-  default:  
-    pos = formula.find_first_of("+-*/()");
-    break;
-  }
-  if ( pos == std::string::npos ) {
-    pos = formula.size();
-  }
-  std::string itemString = formula.substr(0, pos);
-  SlFormulaItem result;
-  if ( itemString.size() == 1 && !isdigit(itemString[0]) ) {
-    result = SlFormulaItem( itemString[0] );
-  }
-  else {
-    double data;
-    doubleFromString( itemString, data );
-    result = SlFormulaItem( data );
-  }
-  formula = formula.substr( pos );
-  return result;
-}
-
-
-
 void
 SlValueParser::parseFormula(const std::vector<std::string>& stringValues, unsigned int& i, double& value)
 {
   std::string formula = assembleFormula(stringValues, i);
-  std::queue<SlFormulaItem> outputQueue = shuntFormula(formula);
-
-  value = calculateFormula( outputQueue );
+  value = compileFormula(formula)->evaluate( screen_width_, screen_height_ );
 }
 
 
 
-std::queue<SlFormulaItem>
-SlValueParser::shuntFormula(std::string& formula)
+std::vector<std::string>
+SlValueParser::resolveFormulas(const std::vector<std::string>& stringValues)
 {
-  std::queue<SlFormulaItem> outputQueue;
-  std::stack<SlFormulaItem> operatorStack; 
-
-  bool isNegative = false;                   //!< Check for leading unary -.
-  while ( !formula.empty() ) {
-    SlFormulaItem currentItem = getNextItem( formula );
-    switch (currentItem.what) {
-    case 'n':
-      if ( isNegative ) {
-	currentItem.data *= -1;
-	isNegative = false;
-      }
-      outputQueue.push( currentItem );
-      break;
-    case '+': case '-': case '*': case '/':
-      if ( outputQueue.empty() ) {              //!< Leading unary - (or plus)
-	if ( currentItem.what == '-' ) isNegative = true;
-	break;
-      }
-      while ( !operatorStack.empty() && operatorStack.top().precedence >= currentItem.precedence ) {
-	outputQueue.push( operatorStack.top() );
-	operatorStack.pop();
-      }
-      operatorStack.push(currentItem);
-      break;
-    case '(':
-      operatorStack.push(currentItem);
-      break;
-    case ')':
-      while ( !operatorStack.empty() && operatorStack.top().what != '(' ) {
-	outputQueue.push( operatorStack.top() );
-	operatorStack.pop();
-      }
-      operatorStack.pop();   //!< Should be '(' on top, discard.
-      break;
+  std::vector<std::string> result;
+  result.reserve( stringValues.size() );
+  for ( unsigned int i = 0 ; i < stringValues.size() ; ++i ) {
+    if ( !stringValues[i].empty() && stringValues[i][0] == '\"' ) {
+      double value;
+      parseFormula(stringValues, i, value);
+      char number[32];
+      snprintf( number, sizeof(number), "%.17g", value );
+      result.push_back(number);
     }
+    else
+      result.push_back( stringValues[i] );
   }
-      
-  while ( !operatorStack.empty() ) {
-    outputQueue.push( operatorStack.top() );
-    operatorStack.pop();
-  }
-  return outputQueue;
+  return result;
 }
 
 